@@ -90,6 +90,23 @@ const std::vector<std::string> Defaults = {
   "nqbnrkrb/pppppppp/8/8/8/8/PPPPPPPP/NQBNRKRB w KQkq - 0 1",
   "setoption name UCI_Chess960 value false"
 };
+
+// Positions within reach of the tablebases, to measure the cost of probing
+const std::vector<std::string> Endgames = {
+  "setoption name UCI_Chess960 value false",
+  "8/8/8/4k3/8/8/4P3/4K3 w - - 0 1",
+  "8/8/8/4k3/8/8/8/4KBN1 w - - 0 1",
+  "8/8/8/3k4/8/4b3/8/R3K3 w - - 0 1",
+  "8/8/8/8/8/3k4/3r4/Q3K3 w - - 0 1",
+  "8/8/8/8/8/8/kp6/5K1Q w - - 0 1",
+  "8/8/8/8/3k4/8/3p4/K1N1N3 w - - 0 1",
+  "1K1k4/1P6/8/8/8/8/r7/2R5 w - - 0 1",
+  "4k3/8/4K3/4P3/8/8/r7/7R b - - 0 1",
+  "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+  "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+  "8/8/4k3/3p4/3P1K2/8/5R2/5r2 w - - 0 1",
+  "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1"
+};
 // clang-format on
 
 // clang-format off
@@ -383,6 +400,7 @@ namespace Sugar::Benchmark {
 // bench 64 1 100000 default nodes  : search default positions for 100K nodes each
 // bench 64 4 5000 current movetime : search current position with 4 threads for 5 sec
 // bench 16 1 5 blah perft          : run a perft 5 on positions in file "blah"
+// bench 16 1 20 endgame            : search the tablebase endgame positions up to depth 20
 std::vector<std::string> setup_bench(const std::string& currentFen, std::istream& is) {
 
     std::vector<std::string> fens, list;
@@ -400,6 +418,9 @@ std::vector<std::string> setup_bench(const std::string& currentFen, std::istream
     if (fenFile == "default")
         fens = Defaults;
 
+    else if (fenFile == "endgame")
+        fens = Endgames;
+
     else if (fenFile == "current")
         fens.push_back(currentFen);
 
@@ -464,8 +485,14 @@ BenchmarkSetup setup_benchmark(std::istream& is) {
     else
         setup.originalInvocation += " " + std::to_string(desiredTimeS);
 
+    if (!(is >> setup.multiPV))
+        setup.multiPV = 1;
+    else
+        setup.originalInvocation += " " + std::to_string(setup.multiPV);
+
     setup.filledInvocation += std::to_string(setup.threads) + " " + std::to_string(setup.ttSize)
-                            + " " + std::to_string(desiredTimeS);
+                            + " " + std::to_string(desiredTimeS) + " "
+                            + std::to_string(setup.multiPV);
 
     auto getCorrectedTime = [&](int ply) {
         // time per move is fit roughly based on LTC games
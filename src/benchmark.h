@@ -30,6 +30,7 @@ std::vector<std::string> setup_bench(const std::string&, std::istream&);
 struct BenchmarkSetup {
     int                      ttSize;
     int                      threads;
+    int                      multiPV;
     std::vector<std::string> commands;
     std::string              originalInvocation;
     std::string              filledInvocation;
@@ -154,6 +154,14 @@ constexpr Bitboard pawn_attacks_bb(Bitboard b) {
                       : shift<SOUTH_WEST>(b) | shift<SOUTH_EAST>(b);
 }
 
+// Returns the squares attacked by a set of knights
+constexpr Bitboard knight_attacks_bb(Bitboard b) {
+    const Bitboard h1 = shift<EAST>(b) | shift<WEST>(b);
+    const Bitboard h2 = shift<EAST>(shift<EAST>(b)) | shift<WEST>(shift<WEST>(b));
+    return shift<NORTH + NORTH>(h1) | shift<SOUTH + SOUTH>(h1) | shift<NORTH>(h2)
+         | shift<SOUTH>(h2);
+}
+
 
 // Returns a bitboard representing an entire line (from board edge
 // to board edge) that intersects the two given squares. If the given squares
@@ -20,6 +20,7 @@
 
 #include <cmath>      // std::ceil
 #include <algorithm>  // std::max
+#include <chrono>
 #include <optional>
 #include <cassert>
 #include <deque>
@@ -32,8 +33,11 @@
 #include <vector>
 
 #include "evaluate.h"
+#include "memory.h"
 #include "misc.h"
+#include "movegen.h"
 #include "nnue/network.h"
+#include "nnue/nnue_accumulator.h"
 #include "nnue/nnue_common.h"
 #include "numa.h"
 #include "perft.h"
@@ -55,11 +59,11 @@
 namespace Sugar {
 	
 #ifdef SUG_FIXED_ZOBRIST
-static void on_exp_enabled(const Option& opt) {
+static void on_exp_enabled(const Option& opt, bool learn) {
     sync_cout << "info string Experience Enabled is now: "
               << (opt ? "enabled" : "disabled") << sync_endl;
     ::Experience::init();
-    if (bool(opt))
+    if (bool(opt) && learn)
         ::Experience::resume_learning();
 }
 
@@ -67,7 +71,7 @@ static void on_exp_file(const Option&) {
     ::Experience::init();
 }
 #else
-static void on_exp_enabled(const Option&) {}
+static void on_exp_enabled(const Option&, bool) {}
 static void on_exp_file(const Option&) {}
 #endif
 
@@ -86,7 +90,8 @@ Engine::Engine(std::optional<std::string> path) :
       numaContext,
       NN::Networks(
         NN::NetworkBig({EvalFileDefaultNameBig, "None", ""}, NN::EmbeddedNNUEType::BIG),
-        NN::NetworkSmall({EvalFileDefaultNameSmall, "None", ""}, NN::EmbeddedNNUEType::SMALL))) {
+        NN::NetworkSmall({EvalFileDefaultNameSmall, "None", ""}, NN::EmbeddedNNUEType::SMALL))),
+    sessions(options, threads, numaContext, networks) {
     pos.set(StartFEN, false, &states->back());
 
 #ifdef SUG_FIXED_ZOBRIST
@@ -113,10 +118,20 @@ Engine::Engine(std::optional<std::string> path) :
           return thread_allocation_information_as_string();
       }));
 
+    // "none" or "cores", see ThreadPool::set()
+    options.add(  //
+      "Thread Placement", Option("none", [this](const Option&) {
+          resize_threads();
+          return thread_allocation_information_as_string();
+      }));
+
+    // Threads of the main search and all the sessions together, see SessionServer
+    options.add("Server Threads", Option(int(get_hardware_concurrency()), 1, MaxThreads));
+
     options.add(  //
       "Hash", Option(16, 1, MaxHashMB, [this](const Option& o) {
           set_tt_size(o);
-          return std::nullopt;
+          return hash_allocation_information_as_string();
       }));
 
     options.add(  //
@@ -131,8 +146,18 @@ Engine::Engine(std::optional<std::string> path) :
     options.add(  //
       "MultiPV", Option(1, 1, 256));
 
+    // Cheaper MultiPV: the helpers own the lines and share them with the
+    // main thread, and each line is searched with a window capped at the
+    // score of the previous one
+    options.add("Fast MultiPV", Option(false));
+
     options.add("Skill Level", Option(20, 0, 20));
 
+    // Limit the strength by searching less instead of picking worse moves only.
+    // Applies to "Skill Level" alone: its cost in Elo is not calibrated, so a
+    // UCI_LimitStrength search keeps the rating scale of the regular search.
+    options.add("Skill Budget", Option(false));
+
     // Time manager knobs (defaults per your request)
     options.add("Move Overhead",          Option(100, 0, 5000));   // ms
     options.add("Minimum Thinking Time",  Option(100, 0, 2000));   // ms
@@ -147,12 +172,18 @@ Engine::Engine(std::optional<std::string> path) :
                 Option(Sugar::Search::Skill::LowestElo, Sugar::Search::Skill::LowestElo,
                        Sugar::Search::Skill::HighestElo));
 
+    // Format and print search output on a dedicated thread
+    options.add("Async Output", Option(false));
+
     // Fail-high/low info throttling (UCI-tunable)
     options.add("FailInfo Enabled",   Option(true));
     options.add("FailInfo First ms",  Option(4000, 0, 60000));
     options.add("FailInfo Min Nodes", Option(10000000, 0, 1000000000));
     options.add("FailInfo Rate ms",   Option(400, 0, 10000));
 
+    // Per-thread cache of network outputs in MB, takes effect on ucinewgame
+    options.add("NNUE Eval Cache", Option(0, 0, 1024));
+
     // Debug: print NNUE weights once per search at root (main thread)
     options.add("NNUE Log Weights", Option(false));
 
@@ -171,6 +202,18 @@ Engine::Engine(std::optional<std::string> path) :
 
     options.add("SyzygyProbeLimit", Option(7, 0, 7));
 
+    options.add(  //
+      "SyzygyPrewarm", Option(false, [](const Option& o) {
+          Tablebases::set_prewarm(o);
+          return std::nullopt;
+      }));
+
+    options.add(  //
+      "SyzygyCache", Option(0, 0, 1024, [](const Option& o) {
+          Tablebases::resize_probe_cache(o);
+          return std::nullopt;
+      }));
+
     options.add("Book1", Option(false));
 
     options.add("Book1 File", Option("", [](const Option& o) {
@@ -200,15 +243,17 @@ Engine::Engine(std::optional<std::string> path) :
     //#ifdef SUG_FIXED_ZOBRIST
     // ===== Sugar Experience UCI options =====
     options.add("Experience Enabled",
-                Option(true, [](const Option& opt) {
-                    on_exp_enabled(opt);
+                Option(true, [this](const Option& opt) {
+                    stop_sessions();
+                    on_exp_enabled(opt, !sessions.size());
                     sync_cout << "info string Experience Enabled is now: "
                               << (opt ? "enabled" : "disabled") << sync_endl;
                     return std::nullopt;
                 }));
 
     options.add("Experience File",
-                Option("Sugar.exp", [](const Option& opt) {
+                Option("Sugar.exp", [this](const Option& opt) {
+                    stop_sessions();
                     on_exp_file(opt);
                     return std::nullopt;
                 }));
@@ -251,6 +296,10 @@ Engine::Engine(std::optional<std::string> path) :
                     return std::nullopt;
                 }));
 
+    options.add("Experience Prefill", Option(false));
+
+    options.add("Experience Prefill Plies", Option(12, 1, 64));
+
     //#endif
 
     options.add("Variety",
@@ -286,6 +335,36 @@ Engine::Engine(std::optional<std::string> path) :
                     return std::nullopt;
                 }));
 
+    // Load networks from preprocessed blobs next to the network files, must be
+    // set before EvalFile and EvalFileSmall to take effect on their loading.
+    // Enabling it also writes the blobs of the embedded networks in use next
+    // to the binary, for their later loads while it is enabled. Their first
+    // load at startup comes before any option is set and never uses a blob.
+    options.add("NNUE Blob Cache", Option(false, [this](const Option& o) {
+                    if (o)
+                    {
+                        networks->big.save_internal_blob(binaryDirectory);
+                        networks->small.save_internal_blob(binaryDirectory);
+                    }
+                    return std::nullopt;
+                }));
+
+    // Directory (like /dev/shm or a hugetlbfs mount) where engines share the
+    // network weights, must be set before EvalFile and EvalFileSmall. When the
+    // networks are replicated on several NUMA nodes, every replica keeps its
+    // own copy of the weights and nothing is saved, but the segment still
+    // spares the parsing to the engines that attach to it.
+    options.add("NNUE Shared Memory", Option(""));
+
+    // Reads the feature transformer rows that fit from an int8 copy of the
+    // weights, halving their memory traffic without changing the evaluation
+    options.add("NNUE Int8 Weights", Option(false, [this](const Option& o) {
+                    return std::optional<std::string>(use_int8_weights(o));
+                }));
+
+    // Prefetch the weights the next evaluation needs while making moves
+    options.add("NNUE Prefetch", Option(false));
+
     options.add(  //
       "EvalFile", Option(EvalFileDefaultNameBig, [this](const Option& o) {
           load_big_network(o);
@@ -411,19 +490,37 @@ void Engine::set_on_verify_networks(std::function<void(std::string_view)>&& f) {
 void Engine::wait_for_search_finished() { threads.main_thread()->wait_for_search_finished(); }
 
 void Engine::set_position(const std::string& fen, const std::vector<std::string>& moves) {
-    // Drop the old state and create a new one
-    states = StateListPtr(new std::deque<StateInfo>(1));
-    pos.set(fen, options["UCI_Chess960"], &states->back());
 
-    for (const auto& move : moves)
+    const bool chess960 = options["UCI_Chess960"];
+
+    // During a game GUIs resend the whole move list with one or two new moves
+    // each time. In that case keep the current position and states, and only
+    // play the new moves, so that the cost does not grow with the game length.
+    const bool extends = states && fen == setupFen && chess960 == setupChess960
+                      && moves.size() >= setupMoves.size()
+                      && std::equal(setupMoves.begin(), setupMoves.end(), moves.begin());
+
+    if (!extends)
     {
-        auto m = UCIEngine::to_move(pos, move);
+        // Drop the old state and create a new one
+        states = StateListPtr(new std::deque<StateInfo>(1));
+        pos.set(fen, chess960, &states->back());
+
+        setupFen      = fen;
+        setupChess960 = chess960;
+        setupMoves.clear();
+    }
+
+    for (size_t i = setupMoves.size(); i < moves.size(); ++i)
+    {
+        auto m = UCIEngine::to_move(pos, moves[i]);
 
         if (m == Move::none())
             break;
 
         states->emplace_back();
         pos.do_move(m, states->back());
+        setupMoves.push_back(moves[i]);
     }
 }
 
@@ -455,10 +552,11 @@ void Engine::set_numa_config_from_option(const std::string& o) {
 
 void Engine::resize_threads() {
     threads.wait_for_search_finished();
-    threads.set(numaContext.get_numa_config(), {options, threads, tt, networks}, updateContext);
-
-    // Reallocate the hash with the new threadpool size
-    set_tt_size(options["Hash"]);
+    // Reallocate the hash with the new threadpool size, unless the threads were
+    // kept and only added or removed, then the hash keeps its contents too
+    if (threads.set(numaContext.get_numa_config(), {options, threads, tt, networks},
+                    updateContext))
+        set_tt_size(options["Hash"]);
     threads.ensure_network_replicated();
 }
 
@@ -478,27 +576,52 @@ void Engine::verify_networks() const {
 
 void Engine::load_networks() {
     networks.modify_and_replicate([this](NN::Networks& networks_) {
-        networks_.big.load(binaryDirectory, options["EvalFile"]);
-        networks_.small.load(binaryDirectory, options["EvalFileSmall"]);
+        networks_.big.load(binaryDirectory, options["EvalFile"], network_caching());
+        networks_.small.load(binaryDirectory, options["EvalFileSmall"], network_caching());
     });
     threads.clear();
     threads.ensure_network_replicated();
 }
 
 void Engine::load_big_network(const std::string& file) {
-    networks.modify_and_replicate(
-      [this, &file](NN::Networks& networks_) { networks_.big.load(binaryDirectory, file); });
+    networks.modify_and_replicate([this, &file](NN::Networks& networks_) {
+        networks_.big.load(binaryDirectory, file, network_caching());
+    });
     threads.clear();
     threads.ensure_network_replicated();
 }
 
 void Engine::load_small_network(const std::string& file) {
-    networks.modify_and_replicate(
-      [this, &file](NN::Networks& networks_) { networks_.small.load(binaryDirectory, file); });
+    networks.modify_and_replicate([this, &file](NN::Networks& networks_) {
+        networks_.small.load(binaryDirectory, file, network_caching());
+    });
     threads.clear();
     threads.ensure_network_replicated();
 }
 
+std::string Engine::use_int8_weights(bool enabled) {
+    std::size_t bigRows = 0, smallRows = 0;
+
+    networks.modify_and_replicate([&](NN::Networks& networks_) {
+        bigRows   = networks_.big.use_int8_weights(enabled);
+        smallRows = networks_.small.use_int8_weights(enabled);
+    });
+    threads.ensure_network_replicated();
+
+    if (!enabled)
+        return "NNUE int8 weights disabled";
+
+    return "NNUE int8 weights for " + std::to_string(bigRows) + "/"
+         + std::to_string(NN::BigFeatureTransformer::InputDimensions) + " rows of the big net, "
+         + std::to_string(smallRows) + "/"
+         + std::to_string(NN::SmallFeatureTransformer::InputDimensions)
+         + " rows of the small net";
+}
+
+Eval::NNUE::NetworkCaching Engine::network_caching() const {
+    return {bool(options["NNUE Blob Cache"]), std::string(options["NNUE Shared Memory"])};
+}
+
 void Engine::save_network(const std::pair<std::optional<std::string>, std::string> files[2]) {
     networks.modify_and_replicate([&files](NN::Networks& networks_) {
         networks_.big.save(files[0].first);
@@ -523,7 +646,10 @@ OptionsMap&       Engine::get_options() { return options; }
 
 std::string Engine::fen() const { return pos.fen(); }
 
-void Engine::flip() { pos.flip(); }
+void Engine::flip() {
+    pos.flip();
+    setupFen.clear();  // The next position command must start over
+}
 
 std::string Engine::visualize() const {
     std::stringstream ss;
@@ -533,6 +659,187 @@ std::string Engine::visualize() const {
 
 int Engine::get_hashfull(int maxAge) const { return tt.hashfull(maxAge); }
 
+std::pair<uint64_t, uint64_t> Engine::get_eval_cache_stats() const {
+    return threads.eval_cache_stats();
+}
+
+std::pair<uint64_t, uint64_t> Engine::get_tb_cache_stats() const {
+    return threads.tb_cache_stats();
+}
+
+// For every legal move of the positions, makes the move, probes the TT and
+// evaluates the result, as the search does. Before each position a buffer of
+// evictMB is read to push the weights out of the caches, outside of the timed
+// part, so that the accumulator updates read cold weight rows: this measures
+// how much of their latency the weight prefetch hides behind the TT probe.
+Engine::EvalBenchStats Engine::eval_bench(const std::vector<std::string>& fens,
+                                          int                             iterations,
+                                          std::size_t                     evictMB,
+                                          bool                            prefetch) {
+    using Clock = std::chrono::steady_clock;
+
+    const bool             chess960 = options["UCI_Chess960"];
+    const auto&            nets     = *networks;
+    auto                   caches   = std::make_unique<NN::AccumulatorCaches>(nets);
+    auto                   stack    = std::make_unique<NN::AccumulatorStack>();
+    std::vector<uint64_t>  evictBuffer(evictMB * 1024 * 1024 / sizeof(uint64_t), 1);
+    std::vector<StateInfo> rootStates(fens.size());
+    std::vector<Position>  positions(fens.size());
+    EvalBenchStats         stats{0, 0, 0};
+    Clock::duration        elapsed{};
+
+    for (std::size_t i = 0; i < fens.size(); ++i)
+        positions[i].set(fens[i], chess960, &rootStates[i]);
+
+    for (int it = 0; it < iterations; ++it)
+        for (auto& p : positions)
+        {
+            StateInfo st;
+            stack->reset();
+
+            for (std::size_t i = 0; i < evictBuffer.size(); i += NN::CacheLineSize / sizeof(uint64_t))
+                stats.evictSum += evictBuffer[i];
+
+            const auto start = Clock::now();
+
+            // Children are then updated incrementally from the root accumulator
+            if (!p.checkers())
+                Eval::evaluate(nets, p, *stack, *caches, 0);
+
+            for (const auto& m : MoveList<LEGAL>(p))
+            {
+                DirtyPiece dp = p.do_move(m, st, p.gives_check(m), &tt);
+                stack->push(dp);
+
+                if (prefetch)
+                    Eval::prefetch_weights(nets, p, dp);
+
+                tt.probe(p.key());
+
+                if (!p.checkers())
+                {
+                    Eval::evaluate(nets, p, *stack, *caches, 0);
+                    ++stats.evals;
+                }
+
+                stack->pop();
+                p.undo_move(m);
+            }
+
+            elapsed += Clock::now() - start;
+        }
+
+    stats.elapsedMs = std::chrono::duration<double, std::milli>(elapsed).count();
+    return stats;
+}
+
+SelfPlay::Result Engine::selfplay(const SelfPlay::Config& config,
+                                  const SelfPlay::Params  params[2]) {
+    verify_networks();
+    threads.wait_for_search_finished();
+
+    // Values that Option::operator=() would reject are skipped here already,
+    // spin values because std::stoi() cannot fail gracefully without exceptions
+    auto set = [&](const std::string& name, const std::string& value) {
+        auto it = options.options_map.find(name);
+        if (it == options.options_map.end())
+            return;
+
+        const std::size_t sign = !value.empty() && value[0] == '-';
+
+        if (it->second.type == "spin"
+            && (value.size() <= sign || value.size() > sign + 9
+                || value.find_first_not_of("0123456789", sign) != std::string::npos))
+            return;
+
+        it->second = value;
+    };
+
+    SelfPlay::Params saved;
+    for (int p : {0, 1})
+        for (const auto& [name, value] : params[p])
+            if (options.count(name))
+                saved.emplace_back(name, options.options_map.find(name)->second.currentValue);
+
+    // The parameters change for every move, keep their info strings quiet
+    auto info    = std::move(options.info);
+    options.info = nullptr;
+
+#ifdef SUG_FIXED_ZOBRIST
+    // The games run concurrently, and the Experience store is not safe for
+    // writes concurrent with probes. Both players are also measured against
+    // the bare engine, without the entries of earlier games or of the user.
+    const bool learningPaused = ::Experience::is_learning_paused();
+    const bool probingPaused  = ::Experience::is_probing_paused();
+    ::Experience::pause_learning();
+    ::Experience::pause_probing();
+#endif
+
+    const auto result = SelfPlay::run(config, options, numaContext.get_numa_config(), networks,
+                                      [&](int player) {
+                                          for (const auto& [name, value] : params[player])
+                                              set(name, value);
+                                      });
+
+#ifdef SUG_FIXED_ZOBRIST
+    if (!learningPaused)
+        ::Experience::resume_learning();
+    if (!probingPaused)
+        ::Experience::resume_probing();
+#endif
+
+    options.info = std::move(info);
+
+    for (const auto& [name, value] : saved)
+        set(name, value);
+
+    return result;
+}
+
+// Before the Experience store is replaced, which the sessions probe
+void Engine::stop_sessions() {
+    sessions.stop_all();
+    sessions.wait_for_search_finished();
+}
+
+size_t Engine::searching_threads() const { return threads.searching_threads(); }
+
+uint64_t Engine::nodes_searched(bool byScan) const {
+    return byScan ? threads.nodes_searched_by_scan() : threads.nodes_searched();
+}
+
+std::vector<std::pair<std::string, double>> Engine::pool_latency(int iterations) {
+    wait_for_search_finished();
+
+    std::vector<std::pair<std::string, double>> result;
+
+    auto measure = [&](std::string name, const std::function<void()>& operation) {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; ++i)
+            operation();
+
+        const std::chrono::duration<double, std::micro> elapsed =
+          std::chrono::steady_clock::now() - start;
+        result.emplace_back(std::move(name), elapsed.count() / iterations);
+    };
+
+    measure("empty job on each thread", [&]() {
+        for (size_t i = 0; i < threads.num_threads(); ++i)
+            threads.run_on_thread(i, []() {});
+        for (size_t i = 0; i < threads.num_threads(); ++i)
+            threads.wait_on_thread(i);
+    });
+    measure("empty parallel_for", [&]() {
+        threads.parallel_for(threads.num_threads(), 1, [](size_t, size_t) {});
+    });
+    measure("TT clear", [&]() { tt.clear(threads); });
+    measure("history clear", [&]() { threads.clear(); });
+    measure("network replication", [&]() { threads.ensure_network_replicated(); });
+
+    return result;
+}
+
 std::vector<std::pair<size_t, size_t>> Engine::get_bound_thread_count_by_numa_node() const {
     auto                                   counts = threads.get_bound_thread_count_by_numa_node();
     const NumaConfig&                      cfg    = numaContext.get_numa_config();
@@ -555,9 +862,34 @@ std::string Engine::numa_config_information_as_string() const {
     return "Available processors: " + cfgStr;
 }
 
+std::string Engine::hash_allocation_information_as_string() const {
+    std::stringstream ss;
+
+    ss << "Hash: " << int(options["Hash"]) << "MB on ";
+
+    if (tt.page_size() >= 1024 * 1024 * 1024)
+        ss << tt.page_size() / (1024 * 1024 * 1024) << "GB huge pages";
+    else if (tt.page_size())
+        ss << tt.page_size() / (1024 * 1024) << "MB huge pages";
+    else
+        ss << (has_large_pages() ? "large pages if available" : "regular pages");
+
+    return ss.str();
+}
+
 std::string Engine::thread_binding_information_as_string() const {
     auto              boundThreadsByNode = get_bound_thread_count_by_numa_node();
     std::stringstream ss;
+
+    // Threads placed on cores are listed by processor, in thread order
+    if (const auto cpus = threads.get_bound_thread_cpus(); !cpus.empty())
+    {
+        ss << "cpu";
+        for (size_t i = 0; i < cpus.size(); ++i)
+            ss << (i ? "," : " ") << cpus[i];
+        return ss.str();
+    }
+
     if (boundThreadsByNode.empty())
         return ss.str();
 
@@ -584,7 +916,8 @@ std::string Engine::thread_allocation_information_as_string() const {
     if (boundThreadsByNodeStr.empty())
         return ss.str();
 
-    ss << " with NUMA node thread binding: ";
+    ss << (threads.get_bound_thread_cpus().empty() ? " with NUMA node thread binding: "
+                                                   : " placed on cores: ");
     ss << boundThreadsByNodeStr;
 
     return ss.str();
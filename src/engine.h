@@ -32,6 +32,8 @@
 #include "numa.h"
 #include "position.h"
 #include "search.h"
+#include "selfplay.h"
+#include "server.h"
 #include "syzygy/tbprobe.h"  // for Sugar::Depth
 #include "thread.h"
 #include "tt.h"
@@ -88,6 +90,8 @@ class Engine {
     void load_big_network(const std::string& file);
     void load_small_network(const std::string& file);
     void save_network(const std::pair<std::optional<std::string>, std::string> files[2]);
+    // returns a description of the rows using int8 weights
+    std::string use_int8_weights(bool enabled);
 
     // utility functions
 
@@ -98,6 +102,41 @@ class Engine {
 
     int get_hashfull(int maxAge = 0) const;
 
+    std::pair<uint64_t, uint64_t> get_eval_cache_stats() const;
+    std::pair<uint64_t, uint64_t> get_tb_cache_stats() const;
+
+    struct EvalBenchStats {
+        uint64_t evals, evictSum;
+        double   elapsedMs;
+    };
+
+    // Evaluates the children of the given positions like the search does, with
+    // cold caches, optionally prefetching the weights when making the moves
+    EvalBenchStats eval_bench(const std::vector<std::string>& fens,
+                              int                             iterations,
+                              std::size_t                     evictMB,
+                              bool                            prefetch);
+
+    // Plays a match between two sets of option values, typically Tune
+    // parameters, and restores the current values afterwards
+    SelfPlay::Result selfplay(const SelfPlay::Config& config, const SelfPlay::Params params[2]);
+
+    // The games hosted besides the main one, see SessionServer
+    SessionServer&       get_sessions() { return sessions; }
+    const SessionServer& get_sessions() const { return sessions; }
+
+    // Nodes of the current search, from the aggregated counter or by visiting
+    // every thread
+    uint64_t nodes_searched(bool byScan) const;
+
+    // Threads of the current search that have searched a node already
+    size_t searching_threads() const;
+
+    // Average time in microseconds of the thread pool operations run between
+    // searches, each repeated the given number of times. This clears the TT
+    // and the histories, as ucinewgame does.
+    std::vector<std::pair<std::string, double>> pool_latency(int iterations);
+
     std::string                            fen() const;
     void                                   flip();
     std::string                            visualize() const;
@@ -106,6 +145,7 @@ class Engine {
     std::string                            numa_config_information_as_string() const;
     std::string                            thread_allocation_information_as_string() const;
     std::string                            thread_binding_information_as_string() const;
+    std::string                            hash_allocation_information_as_string() const;
 
    private:
     const std::string binaryDirectory;
@@ -115,13 +155,24 @@ class Engine {
     Position     pos;
     StateListPtr states;
 
+    // The fen and moves 'pos' was set up from, to detect when a position
+    // command only appends moves to the current position
+    std::string              setupFen;
+    std::vector<std::string> setupMoves;
+    bool                     setupChess960 = false;
+
     OptionsMap                               options;
     ThreadPool                               threads;
     TranspositionTable                       tt;
     LazyNumaReplicated<Eval::NNUE::Networks> networks;
+    SessionServer                            sessions;  // after what its games share
 
     Search::SearchManager::UpdateContext  updateContext;
     std::function<void(std::string_view)> onVerifyNetworks;
+
+    Eval::NNUE::NetworkCaching network_caching() const;
+
+    void stop_sessions();
 };
 
 }  // namespace Sugar
@@ -40,6 +40,39 @@
 
 namespace Sugar {
 
+namespace {
+
+// Runs the given network on the position, unless its output is found in the
+// eval cache. The cache is keyed without the 50-move counter adjustment of
+// Position::key(), which the networks do not see.
+template<bool Big, typename Network, typename Cache>
+Eval::NNUE::NetworkOutput evaluate_net(const Network&                net,
+                                       const Position&               pos,
+                                       Eval::NNUE::AccumulatorStack& accumulators,
+                                       Cache&                        cache,
+                                       Eval::NNUE::EvalCache*        evalCache) {
+
+    if (!evalCache || !evalCache->enabled())
+        return net.evaluate(pos, accumulators, &cache);
+
+    const Key key   = pos.state()->key;
+    auto&     entry = evalCache->entry<Big>(key);
+
+    ++evalCache->lookups;
+
+    if (entry.key == key)
+    {
+        ++evalCache->hits;
+        return {entry.psqt, entry.positional};
+    }
+
+    auto output = net.evaluate(pos, accumulators, &cache);
+    entry       = {key, std::get<0>(output), std::get<1>(output)};
+    return output;
+}
+
+}  // namespace
+
 // Returns a static, purely materialistic evaluation of the position from
 // the point of view of the side to move. It can be divided by PawnValue to get
 // an approximation of the material advantage on the board in terms of pawns.
@@ -51,13 +84,32 @@ int Eval::simple_eval(const Position& pos) {
 
 bool Eval::use_smallnet(const Position& pos) { return std::abs(simple_eval(pos)) > 962; }
 
+// Starts loading the feature transformer weights that evaluate() will need
+// after the given move, for the net it is going to use. Positions in check
+// are not evaluated.
+void Eval::prefetch_weights(const NNUE::Networks& networks,
+                            const Position&       pos,
+                            const DirtyPiece&     dp,
+                            bool                  smallNetOnly) {
+    if (pos.checkers())
+        return;
+
+    if (smallNetOnly || use_smallnet(pos))
+        networks.small.prefetch_weights(pos, dp);
+    else
+        networks.big.prefetch_weights(pos, dp);
+}
+
 // Evaluate is the evaluator for the outer world. It returns a static evaluation
-// of the position from the point of view of the side to move.
+// of the position from the point of view of the side to move. With smallNetOnly
+// the big net is never used, for cheap strength limited searches.
 Value Eval::evaluate(const Eval::NNUE::Networks&    networks,
                      const Position&                pos,
                      Eval::NNUE::AccumulatorStack&  accumulators,
                      Eval::NNUE::AccumulatorCaches& caches,
-                     int                            optimism) {
+                     int                            optimism,
+                     Eval::NNUE::EvalCache*         evalCache,
+                     bool                           smallNetOnly) {
 
     assert(!pos.checkers());
 
@@ -68,9 +120,10 @@ Value Eval::evaluate(const Eval::NNUE::Networks&    networks,
     int wMat = 125;
     int wPos = 131;
 
-    bool smallNet           = use_smallnet(pos);
-    auto [psqt, positional] = smallNet ? networks.small.evaluate(pos, accumulators, &caches.small)
-                                       : networks.big.evaluate(pos, accumulators, &caches.big);
+    bool smallNet           = smallNetOnly || use_smallnet(pos);
+    auto [psqt, positional] =
+      smallNet ? evaluate_net<false>(networks.small, pos, accumulators, caches.small, evalCache)
+               : evaluate_net<true>(networks.big, pos, accumulators, caches.big, evalCache);
 
     // --- NNUE weights selection (Default / Manual / Dynamic) ---
     switch (static_cast<Sugar::Eval::WeightsMode>(Sugar::Eval::gEvalWeights.mode.load())) {
@@ -168,11 +221,12 @@ Value Eval::evaluate(const Eval::NNUE::Networks&    networks,
     Value nnue = (wMat * psqt + wPos * positional) / 128;
 
     // Re-evaluate the position when higher eval accuracy is worth the time spent
-    if (smallNet && (std::abs(nnue) < scaledThreshold))
+    if (smallNet && !smallNetOnly && (std::abs(nnue) < scaledThreshold))
     {
-        std::tie(psqt, positional) = networks.big.evaluate(pos, accumulators, &caches.big);
-        nnue                       = (wMat * psqt + wPos * positional) / 128;
-        smallNet                   = false;
+        std::tie(psqt, positional) =
+          evaluate_net<true>(networks.big, pos, accumulators, caches.big, evalCache);
+        nnue     = (wMat * psqt + wPos * positional) / 128;
+        smallNet = false;
     }
 
     // Blend optimism and eval with nnue complexity
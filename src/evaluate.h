@@ -39,6 +39,7 @@ namespace Eval {
 namespace NNUE {
 struct Networks;
 struct AccumulatorCaches;
+struct EvalCache;
 class AccumulatorStack;
 }
 
@@ -46,11 +47,17 @@ std::string trace(Position& pos, const Eval::NNUE::Networks& networks);
 
 int   simple_eval(const Position& pos);
 bool  use_smallnet(const Position& pos);
+void  prefetch_weights(const NNUE::Networks& networks,
+                       const Position&       pos,
+                       const DirtyPiece&     dp,
+                       bool                  smallNetOnly = false);
 Value evaluate(const NNUE::Networks&          networks,
                const Position&                pos,
                Eval::NNUE::AccumulatorStack&  accumulators,
                Eval::NNUE::AccumulatorCaches& caches,
-               int                            optimism);
+               int                            optimism,
+               Eval::NNUE::EvalCache*         evalCache    = nullptr,
+               bool                           smallNetOnly = false);
 }  // namespace Eval
 
 }  // namespace Sugar
@@ -16,9 +16,13 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <functional>
 #include <iostream>
 #include <iomanip>
+#include <optional>
 #include <string>
 #include <sstream>
 #include <fstream>
@@ -29,6 +33,16 @@
 #include <thread>
 #include <unordered_set>
 #include <type_traits>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define USE_FILE_LOCKING
+#endif
 #include "misc.h"
 #include "movegen.h" 
 #include "position.h"
@@ -90,6 +104,7 @@ using SugaRKeyMap = SugaRMap<Key, tVal>;
 #endif
 
 using i64 = std::int64_t;
+using u64 = std::uint64_t;
 
 namespace Experience {
 
@@ -108,15 +123,21 @@ class ExperienceReader {
     bool check_signature_set_count(std::ifstream&     input,
                                    const usize        inputLength,
                                    const std::string& signature,
-                                   const usize        entrySize) {
+                                   const usize        entrySize,
+                                   const bool         allowTornTail = false) {
         assert(input && input.is_open() && inputLength);
 
-        // Check if data length contains full experience entries
+        // Check if data length contains full experience entries. A writer that
+        // died in the middle of an append may have left a partial entry at the
+        // end, which is ignored (and trimmed by the next append) if allowed.
         auto check_exp_count = [&]() -> bool {
+            if (inputLength < signature.length())
+                return false;
+
             const usize entriesDataLength = inputLength - signature.length();
             entriesCount                  = entriesDataLength / entrySize;
 
-            if (entriesCount * entrySize != entriesDataLength)
+            if (entriesCount * entrySize != entriesDataLength && !allowTornTail)
             {
                 entriesCount = 0;
                 return false;
@@ -240,7 +261,8 @@ class ExperienceReader final: public Experience::ExperienceReader {
     int get_version() override { return ExperienceVersion; }
 
     bool check_signature(std::ifstream& input, const usize inputLength) override {
-        return check_signature_set_count(input, inputLength, ExperienceSignature, sizeof(ExpEntry));
+        return check_signature_set_count(input, inputLength, ExperienceSignature, sizeof(ExpEntry),
+                                         true);
     }
 
     bool read(std::ifstream& input, Current::ExpEntry* exp) override {
@@ -255,6 +277,175 @@ class ExperienceReader final: public Experience::ExperienceReader {
 
 }
 
+////////////////////////////////////////////////////////////////
+// Journal
+////////////////////////////////////////////////////////////////
+namespace {
+
+// Entries carry a checksum of their fields in the padding bytes, so that
+// readers can skip torn or garbled entries. Zero marks entries written
+// without a checksum, which are accepted as they are.
+u16 entry_checksum(const Current::ExpEntry* exp) {
+    u64 h = exp->key;
+
+    for (const u64 v : {u64(exp->move.raw()), u64(u32(exp->value)), u64(u32(exp->depth)),
+                        u64(exp->count)})
+        h = (h ^ v) * 0x9E3779B97F4A7C15ULL, h ^= h >> 29;
+
+    const u16 c = u16(h ^ (h >> 16) ^ (h >> 32) ^ (h >> 48));
+    return c ? c : 1;
+}
+
+bool checksum_ok(const Current::ExpEntry* exp) {
+    u16 c;
+    std::memcpy(&c, exp->padding, sizeof(c));
+    return c == 0 || c == entry_checksum(exp);
+}
+
+// The experience file is an append-only journal shared by all the instances
+// using it. Appends hold an exclusive flock() on the file and readers of new
+// entries a shared one. A full save writes a new file and renames it over the
+// journal while holding the lock of the old one, so whoever was waiting for
+// that lock opens the file again. Without file locking (Windows) the accesses
+// are not coordinated, as before.
+class JournalFile {
+   public:
+    JournalFile(const std::string& fn, const bool write) {
+#ifdef USE_FILE_LOCKING
+        while ((fd = open(fn.c_str(), write ? O_RDWR | O_CREAT | O_APPEND : O_RDONLY, 0644)) >= 0)
+        {
+            struct stat locked, current;
+
+            if (flock(fd, write ? LOCK_EX : LOCK_SH) != 0)
+            {
+                close(fd);
+                fd = -1;
+                break;
+            }
+
+            if (fstat(fd, &locked) == 0 && stat(fn.c_str(), &current) == 0
+                && locked.st_dev == current.st_dev && locked.st_ino == current.st_ino)
+                break;
+
+            close(fd);
+        }
+#else
+        file = std::fopen(fn.c_str(), write ? "ab+" : "rb");
+#endif
+    }
+
+    ~JournalFile() {
+#ifdef USE_FILE_LOCKING
+        if (fd >= 0)
+            close(fd);  // Also releases the lock
+#else
+        if (file)
+            std::fclose(file);
+#endif
+    }
+
+    JournalFile(const JournalFile&)            = delete;
+    JournalFile& operator=(const JournalFile&) = delete;
+
+#ifdef USE_FILE_LOCKING
+    bool is_open() const { return fd >= 0; }
+
+    // Identifies the file, to notice when it has been replaced by a full save
+    u64 id() const {
+        struct stat st;
+        return fstat(fd, &st) == 0 ? u64(st.st_ino) : 0;
+    }
+
+    usize size() const {
+        struct stat st;
+        return fstat(fd, &st) == 0 ? usize(st.st_size) : 0;
+    }
+
+    bool read_at(const usize offset, char* data, usize length) const {
+        for (usize pos = 0; pos < length;)
+        {
+            const ssize_t n = pread(fd, data + pos, length - pos, off_t(offset + pos));
+            if (n <= 0)
+                return false;
+            pos += usize(n);
+        }
+        return true;
+    }
+
+    bool append(const char* data, const usize length) {
+        for (usize pos = 0; pos < length;)
+        {
+            const ssize_t n = write(fd, data + pos, length - pos);
+            if (n <= 0)
+                return false;
+            pos += usize(n);
+        }
+        return true;
+    }
+
+    bool truncate(const usize length) { return ftruncate(fd, off_t(length)) == 0; }
+#else
+    bool is_open() const { return file != nullptr; }
+
+    u64 id() const { return 0; }
+
+    usize size() const {
+        std::fseek(file, 0, SEEK_END);
+        return usize(std::ftell(file));
+    }
+
+    bool read_at(const usize offset, char* data, const usize length) const {
+        return std::fseek(file, long(offset), SEEK_SET) == 0
+            && std::fread(data, 1, length, file) == length;
+    }
+
+    bool append(const char* data, const usize length) {
+        return std::fwrite(data, 1, length, file) == length && std::fflush(file) == 0;
+    }
+
+    bool truncate(usize) { return false; }
+#endif
+
+   private:
+#ifdef USE_FILE_LOCKING
+    int fd = -1;
+#else
+    std::FILE* file = nullptr;
+#endif
+};
+
+// Renames a completely written file over 'path' and keeps the old file as a
+// backup. With file locking the old file is linked as the backup instead of
+// renamed, so that 'path' never goes missing for the other instances.
+bool replace_file(const std::string& from, const std::string& path) {
+    const std::string backup = path + ".bak";
+
+    std::remove(backup.c_str());
+
+#ifdef USE_FILE_LOCKING
+    if (link(path.c_str(), backup.c_str()) != 0)
+        sync_cout << "info string Could not create backup of current experience file"
+                  << sync_endl;
+
+    if (rename(from.c_str(), path.c_str()) == 0)
+        return true;
+#else
+    const bool backedUp = Utility::file_exists(path) && rename(path.c_str(), backup.c_str()) == 0;
+
+    if (rename(from.c_str(), path.c_str()) == 0)
+        return true;
+
+    if (backedUp)
+        rename(backup.c_str(), path.c_str());
+#endif
+
+    sync_cout << "info string Could not replace experience file [" << path << "]" << sync_endl;
+    std::remove(from.c_str());
+    return false;
+}
+
+}
+
 ////////////////////////////////////////////////////////////////
 // Type aliases
 ////////////////////////////////////////////////////////////////
@@ -262,6 +453,13 @@ using ExpMap           = SugaRKeyMap<ExpEntryEx*>;
 using ExpIterator      = ExpMap::iterator;
 using ExpConstIterator = ExpMap::const_iterator;
 
+// Positions are spread over maps selected by the high bits of the key (the
+// hasher uses the low ones), so that loader threads can fill them in parallel
+constexpr int   ExpShardBits = 6;
+constexpr usize ExpShards    = usize(1) << ExpShardBits;
+
+constexpr usize shard_of(const Key k) { return usize(k >> (64 - ExpShardBits)); }
+
 ////////////////////////////////////////////////////////////////
 // ExpEntryEx::quality
 ////////////////////////////////////////////////////////////////
@@ -377,6 +575,11 @@ constexpr usize WriteBufferSize = 1024;
 constexpr usize WriteBufferSize = 1024 * 1024 * 16;
 #endif
 
+// Files are loaded by up to MaxLoaders threads, each getting at least
+// MinEntriesPerLoader entries
+constexpr usize MaxLoaders          = 8;
+constexpr usize MinEntriesPerLoader = 1 << 18;
+
 class ExperienceData {
    private:
     std::string _filename;
@@ -386,7 +589,12 @@ class ExperienceData {
     std::vector<ExpEntryEx*> _newMultiPvExp;
     std::vector<ExpEntryEx*> _oldExpData;
 
-    ExpMap _mainExp;
+    std::array<ExpMap, ExpShards> _mainExp;
+
+    // How far the experience file has been read, to take in the entries that
+    // other instances append to it without reloading it
+    usize _journalSize = 0;
+    u64   _journalId   = 0;
 
     bool                    _loading;
     std::atomic<bool>       _abortLoading;
@@ -414,7 +622,8 @@ class ExperienceData {
             delete p;
 
         // Clear
-        _mainExp.clear();
+        for (auto& map : _mainExp)
+            map.clear();
         _oldExpData.clear();
         _expData.clear();
     }
@@ -429,13 +638,22 @@ class ExperienceData {
         _newMultiPvExp.clear();
     }
 
-    bool link_entry(ExpEntryEx* exp) {
-        ExpIterator itr = _mainExp.find(exp->key);
+    [[nodiscard]] usize positions_count() const {
+        usize count = 0;
+        for (const auto& map : _mainExp)
+            count += map.size();
+        return count;
+    }
+
+    bool link_entry(ExpEntryEx* exp) { return link_entry(_mainExp[shard_of(exp->key)], exp); }
+
+    static bool link_entry(ExpMap& map, ExpEntryEx* exp) {
+        ExpIterator itr = map.find(exp->key);
 
         // If new entry: insert into map and continue
-        if (itr == _mainExp.end())
+        if (itr == map.end())
         {
-            _mainExp[exp->key] = exp;
+            map[exp->key] = exp;
             return true;
         }
 
@@ -481,6 +699,168 @@ class ExperienceData {
         __builtin_unreachable();
     }
 
+    // Links the complete entries appended to the file since it was last read,
+    // skipping the ones with a bad checksum. Returns the number of entries.
+    usize ingest(const JournalFile& in) {
+        const usize sigLength = std::strlen(Current::ExperienceSignature);
+        const usize length    = in.size();
+        const u64   id        = in.id();
+
+        if (_journalSize == 0 || id != _journalId || length < _journalSize)
+        {
+            std::string signature(sigLength, '\0');
+
+            // A file that could not be loaded is read from the start, a file
+            // replaced by a full save only from its current end
+            if (_journalSize == 0 && length >= sigLength
+                && in.read_at(0, signature.data(), sigLength)
+                && signature == Current::ExperienceSignature)
+                _journalSize = sigLength;
+            else
+                _journalSize = length;
+
+            _journalId = id;
+        }
+
+        const usize count = (length - _journalSize) / sizeof(Current::ExpEntry);
+
+        if (count == 0)
+            return 0;
+
+        std::vector<char> data(count * sizeof(Current::ExpEntry));
+        auto*             expData = (ExpEntryEx*) malloc(count * sizeof(ExpEntryEx));
+
+        if (!expData || !in.read_at(_journalSize, data.data(), data.size()))
+        {
+            free(expData);
+            return 0;
+        }
+
+        usize       linked = 0;
+        ExpEntryEx* exp    = expData;
+
+        for (usize i = 0; i < count; ++i)
+        {
+            std::memcpy((char*) exp, data.data() + i * sizeof(Current::ExpEntry),
+                        sizeof(Current::ExpEntry));
+            exp->next = nullptr;
+
+            if (!checksum_ok(exp))
+                continue;
+
+            link_entry(exp++);
+            linked++;
+        }
+
+        _expData.push_back(expData);
+        _journalSize += data.size();
+
+        return linked;
+    }
+
+    // Loads the entries of a current version file with several threads. Each
+    // thread first reads a range of the file and sorts its entries by shard,
+    // then links the entries of its own shards, taking the ranges in file
+    // order so that the merges happen in the same order as when loading
+    // serially. The loading may run in the background while a search uses
+    // the threads of the pool, so it has its own threads instead of going
+    // through ThreadPool::parallel_for().
+    bool _load_parallel(const std::string& fn,
+                        ExpEntryEx*        expData,
+                        const usize        expCount,
+                        const usize        threadCount,
+                        usize&             duplicateMoves,
+                        usize&             damagedMoves) {
+        constexpr usize ChunkEntries = 4096;
+
+        const usize sigLength = std::strlen(Current::ExperienceSignature);
+
+        std::vector<std::vector<std::vector<ExpEntryEx*>>> sorted(
+          threadCount, std::vector<std::vector<ExpEntryEx*>>(ExpShards));
+        std::vector<usize>       duplicates(threadCount), damaged(threadCount);
+        std::atomic<bool>        failed{false};
+        std::vector<std::thread> loaders;
+
+        auto read_range = [&](const usize t) {
+            const usize begin = expCount * t / threadCount;
+            const usize end   = expCount * (t + 1) / threadCount;
+
+            std::ifstream     in(Utility::map_path(fn), std::ios::in | std::ios::binary);
+            std::vector<char> chunk(ChunkEntries * sizeof(Current::ExpEntry));
+
+            in.seekg(std::streamoff(sigLength + begin * sizeof(Current::ExpEntry)));
+
+            for (usize i = begin; i < end;)
+            {
+                if (_abortLoading.load(std::memory_order_relaxed)
+                    || failed.load(std::memory_order_relaxed))
+                    return;
+
+                const usize n = std::min(ChunkEntries, end - i);
+
+                if (!in.read(chunk.data(), std::streamsize(n * sizeof(Current::ExpEntry))))
+                {
+                    sync_cout << "info string Failed to read experience entries #" << i + 1
+                              << " to #" << i + n << " of " << expCount << sync_endl;
+                    failed = true;
+                    return;
+                }
+
+                for (usize j = 0; j < n; ++j, ++i)
+                {
+                    ExpEntryEx* exp = expData + i;
+
+                    std::memcpy((char*) exp, chunk.data() + j * sizeof(Current::ExpEntry),
+                                sizeof(Current::ExpEntry));
+                    exp->next = nullptr;
+
+                    if (checksum_ok(exp))
+                        sorted[t][shard_of(exp->key)].push_back(exp);
+                    else
+                        damaged[t]++;
+                }
+            }
+        };
+
+        auto link_shards = [&](const usize t) {
+            for (usize shard = t; shard < ExpShards; shard += threadCount)
+                for (auto& range : sorted)
+                {
+                    if (_abortLoading.load(std::memory_order_relaxed))
+                        return;
+
+                    for (ExpEntryEx* exp : range[shard])
+                        if (!link_entry(_mainExp[shard], exp))
+                            duplicates[t]++;
+
+                    range[shard] = std::vector<ExpEntryEx*>();
+                }
+        };
+
+        for (const auto& job : {std::function<void(usize)>(read_range),
+                                std::function<void(usize)>(link_shards)})
+        {
+            for (usize t = 0; t < threadCount; ++t)
+                loaders.emplace_back(job, t);
+
+            for (auto& th : loaders)
+                th.join();
+
+            loaders.clear();
+
+            if (failed)
+                return false;
+        }
+
+        for (usize t = 0; t < threadCount; ++t)
+        {
+            duplicateMoves += duplicates[t];
+            damagedMoves += damaged[t];
+        }
+
+        return true;
+    }
+
     bool _load(const std::string& fn) {
         std::ifstream in(Utility::map_path(fn), std::ios::in | std::ios::binary | std::ios::ate);
 
@@ -563,13 +943,32 @@ class ExperienceData {
         }
 
         // Few variables to be used for statistical information
-        const usize prevPosCount = _mainExp.size();
+        const usize     prevPosCount = positions_count();
+        const TimePoint startTime    = now();
 
         // Load experience entries
         usize       duplicateMoves = 0;
+        usize       damagedMoves   = 0;
         ExpEntryEx* exp            = expData;
 
-        for (usize i = 0; i < expCount; ++i, ++exp)
+        const usize threadCount =
+          reader->get_version() == Current::ExperienceVersion
+            ? std::clamp<usize>(expCount / MinEntriesPerLoader, 1,
+                                std::clamp<usize>(std::thread::hardware_concurrency(), 1, MaxLoaders))
+            : 1;
+
+        if (threadCount > 1)
+        {
+            in.close();
+
+            if (!_load_parallel(fn, expData, expCount, threadCount, duplicateMoves, damagedMoves))
+            {
+                free(expData);
+                return false;
+            }
+        }
+
+        for (usize i = 0; threadCount == 1 && i < expCount; ++i, ++exp)
         {
             if (_abortLoading.load(std::memory_order_relaxed))
                 break;
@@ -587,17 +986,33 @@ class ExperienceData {
                 return false;
             }
 
+            // Skip damaged entries
+            if (reader->get_version() == Current::ExperienceVersion && !checksum_ok(exp))
+            {
+                damagedMoves++;
+                continue;
+            }
+
             // Merge
             if (!link_entry(exp))
                 duplicateMoves++;
         }
 
         // Close input file
-        in.close();
+        if (in.is_open())
+            in.close();
 
         // Add buffer to vector so that it will be released later
         _expData.push_back(expData);
 
+        // Entries appended from now on are read by ingest()
+        if (fn == _filename && reader->get_version() == Current::ExperienceVersion)
+        {
+            _journalSize =
+              std::strlen(Current::ExperienceSignature) + expCount * sizeof(Current::ExpEntry);
+            _journalId = JournalFile(Utility::map_path(fn), false).id();
+        }
+
         // Stop if aborted
         if (_abortLoading.load(std::memory_order_relaxed))
             return false;
@@ -623,11 +1038,18 @@ class ExperienceData {
             return false;
 
         // Show some statistics
+        if (damagedMoves)
+            sync_cout << "info string " << fn_disp << " -> Skipped " << damagedMoves
+                      << " damaged moves" << sync_endl;
+
+        const TimePoint loadTime = now() - startTime;
+
         if (prevPosCount)
         {
             sync_cout << "info string " << fn_disp << " -> Total new moves: " << expCount
-                      << ". Total new positions: " << (_mainExp.size() - prevPosCount)
-                      << ". Duplicate moves: " << duplicateMoves << sync_endl;
+                      << ". Total new positions: " << (positions_count() - prevPosCount)
+                      << ". Duplicate moves: " << duplicateMoves << ". Load time: " << loadTime
+                      << " ms (" << threadCount << " thread(s))" << sync_endl;
         }
         else
         {
@@ -636,18 +1058,23 @@ class ExperienceData {
                                 : 0.0; // avoid NaN when file/header has 0 moves
 
             sync_cout << "info string " << fn_disp << " -> Total moves: " << expCount
-                      << ". Total positions: " << _mainExp.size()
+                      << ". Total positions: " << positions_count()
                       << ". Duplicate moves: " << duplicateMoves
                       << ". Fragmentation: " << std::setprecision(2) << std::fixed
-                      << frag << "%" << sync_endl;
+                      << frag << "%. Load time: " << loadTime << " ms (" << threadCount
+                      << " thread(s))" << sync_endl;
         }
 
         return true;
     }
 
+    // Appends the new entries to the file or, if 'saveAll', replaces it by a
+    // file with all the entries and keeps the old one as a backup
     bool _save(const std::string& fn, const bool saveAll) {
-        std::fstream out;
-        out.open(Utility::map_path(fn), std::ios::out | std::ios::binary | std::ios::app);
+        // Holds the file lock until the new entries have been appended, or the
+        // file has been replaced
+        const std::string path = Utility::map_path(fn);
+        JournalFile       out(path, true);
 
         if (!out.is_open())
         {
@@ -656,26 +1083,54 @@ class ExperienceData {
             return false;
         }
 
-        // If this is a new file then we need to write the signature first
-        out.seekg(0, std::fstream::end);
-        const usize length = out.tellg();
-        out.seekg(0, std::fstream::beg);
+        const usize sigLength = std::strlen(Current::ExperienceSignature);
+        const usize length    = out.size();
 
+        // If this is a new file then we need to write the signature first
         if (length == 0)
         {
-            out.seekp(0, std::fstream::beg);
-
-            out << Current::ExperienceSignature;
-            if (!out)
+            if (!out.append(Current::ExperienceSignature, sigLength))
             {
                 sync_cout << "info string Failed to write signature to experience file [" << fn
                           << "]" << sync_endl;
                 return false;
             }
         }
+        // Drop a partial entry left by a writer that died while appending,
+        // otherwise all the entries after it would be misaligned
+        else if (length > sigLength && (length - sigLength) % sizeof(Current::ExpEntry))
+            out.truncate(length - (length - sigLength) % sizeof(Current::ExpEntry));
+
+        // Take in what other instances appended since we last read the file, so
+        // that our own entries can be skipped when reading it next time, and a
+        // full save does not lose them
+        const bool journal = fn == _filename;
+
+        if (journal)
+            ingest(out);
 
-        // Reposition writing pointer to end of file
-        out.seekp(std::ios::end);
+        // A full save is written to a new file first, the journal stays intact
+        // until the new file is complete
+        const std::string tmpPath = path + ".tmp";
+
+        if (saveAll)
+            std::remove(tmpPath.c_str());
+
+        std::optional<JournalFile> full;
+        if (saveAll)
+            full.emplace(tmpPath, true);
+
+        JournalFile& target = saveAll ? *full : out;
+
+        if (saveAll
+            && (!target.is_open()
+                || !target.append(Current::ExperienceSignature, sigLength)))
+        {
+            sync_cout << "info string Failed to write experience file [" << tmpPath << "]"
+                      << sync_endl;
+            std::remove(tmpPath.c_str());
+            return false;
+        }
 
         std::vector<char> writeBuffer;
         writeBuffer.reserve(WriteBufferSize);
@@ -683,16 +1138,19 @@ class ExperienceData {
         auto write_entry = [&](const Current::ExpEntry* exp, const bool force) -> bool {
             if (exp)
             {
-                const char* data = reinterpret_cast<const char*>(exp);
+                const char* data     = reinterpret_cast<const char*>(exp);
+                const u16   checksum = entry_checksum(exp);
+
                 writeBuffer.insert(writeBuffer.end(), data, data + sizeof(Current::ExpEntry));
+                std::memcpy(writeBuffer.data() + writeBuffer.size() - sizeof(Current::ExpEntry)
+                              + offsetof(Current::ExpEntry, padding),
+                            &checksum, sizeof(checksum));
             }
 
             bool success = true;
             if (force || writeBuffer.size() >= WriteBufferSize)
             {
-                out.write(writeBuffer.data(), writeBuffer.size());
-                if (!out)
-                    success = false;
+                success = target.append(writeBuffer.data(), writeBuffer.size());
 
                 writeBuffer.clear();
             }
@@ -711,48 +1169,52 @@ class ExperienceData {
             for (ExpEntryEx* expEx : _newMultiPvExp)
                 link_entry(expEx);
 
-            for (auto& x : _mainExp)
+            for (auto& map : _mainExp)
             {
-                allPositions++;
-                ExpEntryEx* exp = x.second;
-
-                // Scale counts
-                u16         maxCount = std::numeric_limits<u8>::min();
-                ExpEntryEx* exp1     = exp;
-
-                while (exp1)
+                for (auto& x : map)
                 {
-                    maxCount = std::max(maxCount, exp1->count);
-                    exp1     = exp1->next;
-                }
+                    allPositions++;
+                    ExpEntryEx* exp = x.second;
 
-                // Scale down
-                const u16 scale = 1 + maxCount / 128;
-                exp1            = exp;
+                    // Scale counts
+                    u16         maxCount = std::numeric_limits<u8>::min();
+                    ExpEntryEx* exp1     = exp;
 
-                while (exp1)
-                {
-                    exp1->count = std::max(exp1->count / scale, 1);
-                    exp1        = exp1->next;
-                }
+                    while (exp1)
+                    {
+                        maxCount = std::max(maxCount, exp1->count);
+                        exp1     = exp1->next;
+                    }
 
-                // Save
-                while (exp)
-                {
-                    if (exp->depth >= MinDepth)
+                    // Scale down
+                    const u16 scale = 1 + maxCount / 128;
+                    exp1            = exp;
+
+                    while (exp1)
                     {
-                        allMoves++;
+                        exp1->count = std::max(exp1->count / scale, 1);
+                        exp1        = exp1->next;
+                    }
 
-                        if (!write_entry(exp, false))
+                    // Save
+                    while (exp)
+                    {
+                        if (exp->depth >= MinDepth)
                         {
-                            sync_cout
-                              << "info string Failed to save experience entry to experience file ["
-                              << fn << "]" << sync_endl;
-                            return false;
+                            allMoves++;
+
+                            if (!write_entry(exp, false))
+                            {
+                                sync_cout
+                                  << "info string Failed to save experience entry to experience file ["
+                                  << fn << "]" << sync_endl;
+                                std::remove(tmpPath.c_str());
+                                return false;
+                            }
                         }
-                    }
 
-                    exp = exp->next;
+                        exp = exp->next;
+                    }
                 }
             }
 
@@ -803,7 +1265,22 @@ class ExperienceData {
         }
 
         //Flush buffer
-        write_entry(nullptr, true);
+        if (!write_entry(nullptr, true) && saveAll)
+        {
+            sync_cout << "info string Failed to write experience file [" << tmpPath << "]"
+                      << sync_endl;
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+
+        if (saveAll && !replace_file(tmpPath, path))
+            return false;
+
+        if (journal)
+        {
+            _journalId   = target.id();
+            _journalSize = target.size();
+        }
 
         //Clear new moves
         clear_new_exp();
@@ -879,62 +1356,25 @@ class ExperienceData {
         if (!ignoreLoadingCheck)
             wait_for_load_finished();
 
-        if (!has_new_exp() && (!saveAll || _mainExp.empty()))
+        if (!has_new_exp() && (!saveAll || positions_count() == 0))
             return;
 
-        //Step 1: Create backup only if 'saveAll' is 'true'
-        const std::string expFilename = Utility::map_path(fn);
-        std::string       backupExpFilename;
-
-        if (saveAll && Utility::file_exists(expFilename))
-        {
-            backupExpFilename = expFilename + ".bak";
-
-            // If backup file already exists then delete it
-            if (Utility::file_exists(backupExpFilename))
-            {
-                if (remove(backupExpFilename.c_str()) != 0)
-                {
-                    sync_cout << "info string Could not deleted existing backup file: "
-                              << backupExpFilename << sync_endl;
-
-                    // Clear backup filename
-                    backupExpFilename.clear();
-                }
-            }
+        _save(fn, saveAll);
+    }
 
-            // Rename current experience file
-            if (!backupExpFilename.empty())
-            {
-                if (rename(expFilename.c_str(), backupExpFilename.c_str()) != 0)
-                {
-                    sync_cout << "info string Could not create backup of current experience file"
-                              << sync_endl;
+    // Takes in the entries appended to the experience file by other instances
+    usize refresh() {
+        wait_for_load_finished();
 
-                    // Clear backup filename
-                    backupExpFilename.clear();
-                }
-            }
-        }
+        const JournalFile in(Utility::map_path(_filename), false);
 
-        // Step 2: Save
-        if (!_save(fn, saveAll))
-        {
-            // Step 2a: Restore backup in case of failure while saving
-            if (!backupExpFilename.empty())
-            {
-                if (rename(backupExpFilename.c_str(), expFilename.c_str()) != 0)
-                {
-                    sync_cout << "info string Could not restore backup experience file: "
-                              << backupExpFilename << sync_endl;
-                }
-            }
-        }
+        return in.is_open() ? ingest(in) : 0;
     }
 
     [[nodiscard]] const ExpEntryEx* probe(const Key k) const {
-        ExpConstIterator itr = _mainExp.find(k);
-        if (itr == _mainExp.end())
+        const ExpMap&    map = _mainExp[shard_of(k)];
+        ExpConstIterator itr = map.find(k);
+        if (itr == map.end())
             return nullptr;
 
         assert(itr->second->key == k);
@@ -966,6 +1406,7 @@ class ExperienceData {
 ExperienceData* currentExperience = nullptr;
 bool            experienceEnabled = true;
 bool            learningPaused    = false;
+bool            probingPaused     = false;
 
 }
 
@@ -980,20 +1421,12 @@ void touch() {
     if (filename.empty())
         return;
 
-    std::fstream out;
-    out.open(Utility::map_path(filename), std::ios::out | std::ios::binary | std::ios::app);
-    if (!out.is_open())
-        return;
+    JournalFile out(Utility::map_path(filename), true);
 
     // If the file is new, write only the signature/header
-    out.seekg(0, std::fstream::end);
-    const usize length = (usize)out.tellg();
-    out.seekg(0, std::fstream::beg);
-
-    if (length == 0) {
-        out.seekp(0, std::fstream::beg);
-        out << Current::ExperienceSignature;  // no entries, no log
-    }
+    if (out.is_open() && out.size() == 0)
+        out.append(Current::ExperienceSignature,
+                   std::strlen(Current::ExperienceSignature));  // no entries, no log
 }
 
 void init() {
@@ -1020,7 +1453,7 @@ void init() {
     currentExperience->load(filename, false);
 }
 
-bool enabled() { return experienceEnabled; }
+bool enabled() { return experienceEnabled && !probingPaused; }
 
 void unload() {
     save();
@@ -1037,6 +1470,17 @@ void save() {
     currentExperience->save(currentExperience->filename(), false, false);
 }
 
+void refresh() {
+    if (!currentExperience)
+        return;
+
+    const usize count = currentExperience->refresh();
+
+    if (count)
+        sync_cout << "info string Experience: " << count
+                  << " new move(s) from other instances" << sync_endl;
+}
+
 const ExpEntryEx* probe(const Key k) {
     assert(experienceEnabled);
     if (!currentExperience)
@@ -1708,6 +2152,10 @@ void pause_learning() { learningPaused = true; }
 void resume_learning() { learningPaused = false; }
 bool is_learning_paused() { return learningPaused; }
 
+void pause_probing() { probingPaused = true; }
+void resume_probing() { probingPaused = false; }
+bool is_probing_paused() { return probingPaused; }
+
 void add_pv_experience(const Key k, const Move m, const Value v, const Depth d) {
     // Drop writes during bench, when disabled, paused, or readonly
     if (!currentExperience
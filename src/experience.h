@@ -218,6 +218,10 @@ void save();
 
 void wait_for_loading_finished();
 
+// Reads the moves other instances appended to the experience file since it
+// was loaded. Must not be called while searching.
+void refresh();
+
 const ExpEntryEx* probe(ExpKey k);
 const ExpEntryEx* find_best_entry(ExpKey k);
 
@@ -235,6 +239,11 @@ void pause_learning();
 void resume_learning();
 bool is_learning_paused();
 
+// While paused, enabled() is false and the search does not probe the store
+void pause_probing();
+void resume_probing();
+bool is_probing_paused();
+
 void add_pv_experience(ExpKey k, ExpMove m, ExpValue v, ExpDepth d);
 void add_multipv_experience(ExpKey k, ExpMove m, ExpValue v, ExpDepth d);
 
@@ -18,6 +18,7 @@
 
 #include "memory.h"
 
+#include <cassert>
 #include <cstdlib>
 
 #if __has_include("features.h")
@@ -212,6 +213,54 @@ void* aligned_large_pages_alloc(size_t allocSize) {
 
 #endif
 
+void* huge_pages_alloc(size_t allocSize, size_t& pageSize) {
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    #if !defined(MAP_HUGE_SHIFT)
+        #define MAP_HUGE_SHIFT 26
+    #endif
+
+    // Huge pages must be reserved by the administrator (hugetlbfs pool), if
+    // there are not enough of them mmap() fails and we try the next size.
+    // Rounding up must not waste more than 1/16 of the size.
+    for (const int pageBits : {30, 21})
+    {
+        const size_t page = size_t(1) << pageBits;
+        const size_t size = (allocSize + page - 1) & ~(page - 1);
+
+        if (allocSize < page || size - allocSize > allocSize / 16)
+            continue;
+
+        void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (pageBits << MAP_HUGE_SHIFT),
+                         -1, 0);
+
+        if (mem != MAP_FAILED)
+        {
+            pageSize = page;
+            return mem;
+        }
+    }
+#endif
+
+    pageSize = 0;
+    return aligned_large_pages_alloc(allocSize);
+}
+
+void huge_pages_free(void* mem, [[maybe_unused]] size_t allocSize, size_t pageSize) {
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    if (mem && pageSize)
+    {
+        munmap(mem, (allocSize + pageSize - 1) & ~(pageSize - 1));
+        return;
+    }
+#endif
+
+    assert(!pageSize);
+    aligned_large_pages_free(mem);
+}
+
 bool has_large_pages() {
 
 #if defined(_WIN32)
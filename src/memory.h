@@ -40,6 +40,13 @@ void  aligned_large_pages_free(void* mem);
 
 bool has_large_pages();
 
+// Memory for large tables, backed by explicit huge pages where the system has
+// them reserved: 1GB pages, then 2MB pages, else aligned_large_pages_alloc().
+// pageSize is set to the huge page size used, 0 for the fallback. Free with
+// huge_pages_free() and the same size and pageSize.
+void* huge_pages_alloc(size_t size, size_t& pageSize);
+void  huge_pages_free(void* mem, size_t size, size_t pageSize);
+
 // Frees memory which was placed there with placement new.
 // Works for both single objects and arrays of unknown bound.
 template<typename T, typename FREE_FUNC>
@@ -28,6 +28,16 @@
     #include <array>
     #include <algorithm>
     #include <immintrin.h>
+#elif defined(USE_VECTOR_MOVEGEN) && defined(USE_AVX2)
+    #include <array>
+    #include <algorithm>
+    #include <cstdint>
+    #include <immintrin.h>
+#elif defined(USE_VECTOR_MOVEGEN) && (USE_NEON >= 8)
+    #include <array>
+    #include <algorithm>
+    #include <cstdint>
+    #include <arm_neon.h>
 #endif
 
 namespace Sugar {
@@ -85,6 +95,140 @@ inline Move* splat_moves(Move* moveList, Square from, Bitboard to_bb) {
     return moveList;
 }
 
+#elif defined(USE_VECTOR_MOVEGEN) && (defined(USE_AVX2) || (USE_NEON >= 8))
+
+// Without a native 16-bit compress we write the moves one rank at a time: the
+// 8 candidate moves of a rank are packed with a byte shuffle (pshufb on x86,
+// tbl on AArch64) whose control vector is looked up by the 8-bit target mask.
+// The store offset of every rank is an exclusive prefix sum of the per-rank
+// popcounts, so the stores do not depend on each other. Like the AVX-512 path,
+// each store may write up to 7 moves past the returned end, which the
+// MAX_MOVES sized move buffers can absorb.
+//
+// The shuffles only pay off for dense target sets, sparse ones (most captures,
+// knights and kings) are still written by the scalar loop.
+
+constexpr int VectorSplatMinMoves = 8;
+
+    #if defined(USE_AVX2)
+using MoveVec = __m128i;
+    #else
+using MoveVec = uint8x16_t;
+    #endif
+
+alignas(64) constexpr auto CompressTable = [] {
+    std::array<std::array<uint8_t, 16>, 256> table{};
+    for (int mask = 0; mask < 256; ++mask)
+    {
+        int n = 0;
+        for (int lane = 0; lane < 8; ++lane)
+            if (mask & (1 << lane))
+            {
+                table[mask][n++] = uint8_t(2 * lane);
+                table[mask][n++] = uint8_t(2 * lane + 1);
+            }
+
+        // Out of range indices select zero for both pshufb and tbl
+        while (n < 16)
+            table[mask][n++] = 0x80;
+    }
+    return table;
+}();
+
+inline MoveVec load_moves(const Move* moves) {
+    #if defined(USE_AVX2)
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(moves));
+    #else
+    return vld1q_u8(reinterpret_cast<const uint8_t*>(moves));
+    #endif
+}
+
+inline MoveVec with_from(MoveVec vector, Square from) {
+    #if defined(USE_AVX2)
+    return _mm_or_si128(vector, _mm_set1_epi16(Move(from, SQUARE_ZERO).raw()));
+    #else
+    return vorrq_u8(vector, vreinterpretq_u8_u16(vdupq_n_u16(Move(from, SQUARE_ZERO).raw())));
+    #endif
+}
+
+inline void write_moves(Move* moveList, uint32_t mask, MoveVec vector) {
+    const uint8_t* control = CompressTable[mask].data();
+    #if defined(USE_AVX2)
+    _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(moveList),
+      _mm_shuffle_epi8(vector, _mm_load_si128(reinterpret_cast<const __m128i*>(control))));
+    #else
+    vst1q_u8(reinterpret_cast<uint8_t*>(moveList), vqtbl1q_u8(vector, vld1q_u8(control)));
+    #endif
+}
+
+// Byte r of the result is the number of bits of b below rank r
+constexpr uint64_t rank_offsets(Bitboard b) {
+    b = b - ((b >> 1) & 0x5555555555555555ULL);
+    b = (b & 0x3333333333333333ULL) + ((b >> 2) & 0x3333333333333333ULL);
+    b = (b + (b >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (b * 0x0101010101010101ULL) << 8;
+}
+
+template<Direction offset>
+inline Move* splat_pawn_moves(Move* moveList, Bitboard to_bb) {
+    alignas(64) static constexpr auto SPLAT_TABLE = [] {
+        std::array<Move, 64> table{};
+        for (int8_t i = 0; i < 64; i++)
+        {
+            Square from{std::clamp<int8_t>(i - offset, 0, 63)};
+            table[i] = {Move(from, Square{i})};
+        }
+        return table;
+    }();
+
+    const int count = popcount(to_bb);
+
+    if (count < VectorSplatMinMoves)
+    {
+        while (to_bb)
+        {
+            Square to   = pop_lsb(to_bb);
+            *moveList++ = Move(to - offset, to);
+        }
+        return moveList;
+    }
+
+    const uint64_t offsets = rank_offsets(to_bb);
+
+    for (int r = 0; r < 8; ++r)
+        write_moves(moveList + ((offsets >> (8 * r)) & 0xFF), uint32_t(to_bb >> (8 * r)) & 0xFF,
+                    load_moves(&SPLAT_TABLE[8 * r]));
+
+    return moveList + count;
+}
+
+inline Move* splat_moves(Move* moveList, Square from, Bitboard to_bb) {
+    alignas(64) static constexpr auto SPLAT_TABLE = [] {
+        std::array<Move, 64> table{};
+        for (int8_t i = 0; i < 64; i++)
+            table[i] = {Move(SQUARE_ZERO, Square{i})};
+        return table;
+    }();
+
+    const int count = popcount(to_bb);
+
+    if (count < VectorSplatMinMoves)
+    {
+        while (to_bb)
+            *moveList++ = Move(from, pop_lsb(to_bb));
+        return moveList;
+    }
+
+    const uint64_t offsets = rank_offsets(to_bb);
+
+    for (int r = 0; r < 8; ++r)
+        write_moves(moveList + ((offsets >> (8 * r)) & 0xFF), uint32_t(to_bb >> (8 * r)) & 0xFF,
+                    with_from(load_moves(&SPLAT_TABLE[8 * r]), from));
+
+    return moveList + count;
+}
+
 #else
 
 template<Direction offset>
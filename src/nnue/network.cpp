@@ -18,14 +18,27 @@
 
 #include "network.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <optional>
+#include <sstream>
 #include <type_traits>
 #include <vector>
 
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 #define INCBIN_SILENCE_BITCODE_WARNING
 #include "../incbin/incbin.h"
 
@@ -73,6 +86,15 @@ struct EmbeddedNNUE {
 
 using namespace Sugar::Eval::NNUE;
 
+// C++ way to prepare a buffer for a memory stream
+class MemoryBuffer: public std::basic_streambuf<char> {
+   public:
+    MemoryBuffer(char* p, size_t n) {
+        setg(p, p, p + n);
+        setp(p, p + n);
+    }
+};
+
 EmbeddedNNUE get_embedded(EmbeddedNNUEType type) {
     if (type == EmbeddedNNUEType::BIG)
         return EmbeddedNNUE(gEmbeddedNNUEBigData, gEmbeddedNNUEBigEnd, gEmbeddedNNUEBigSize);
@@ -107,13 +129,80 @@ bool write_parameters(std::ostream& stream, T& reference) {
     return reference.write_parameters(stream);
 }
 
+// Blobs store the parameters in memory layout, which depends on the SIMD
+// instructions the weights were permuted for, so they are tagged by the
+// architecture the engine was built for and checked against these flags.
+#if defined(ARCH)
+constexpr const char* BlobArch = stringify(ARCH);
+#else
+constexpr const char* BlobArch = "unknown";
+#endif
+
+constexpr std::uint32_t BlobMagic = 0x324E4753;  // "SGN2", with a payload hash
+
+constexpr std::uint32_t BlobLayout = 0
+#if defined(USE_AVX512)
+                                   | 1 << 0
+#endif
+#if defined(USE_AVX2)
+                                   | 1 << 1
+#endif
+#if defined(USE_SSSE3)
+                                   | 1 << 2
+#endif
+#if defined(USE_SSE41)
+                                   | 1 << 3
+#endif
+#if defined(USE_SSE2)
+                                   | 1 << 4
+#endif
+#if defined(USE_NEON)
+                                   | 1 << 5
+#endif
+#if defined(USE_VNNI)
+                                   | 1 << 6
+#endif
+#if defined(USE_NEON_DOTPROD)
+                                   | 1 << 7
+#endif
+  ;
+
+// Hash of the source network file, to check that a blob was made from it, and
+// of the payload of a blob, to check that it was not altered since
+inline std::uint64_t
+hash_bytes(const char* data, std::size_t size, std::uint64_t seed = 0xCBF29CE484222325ULL) {
+
+    std::uint64_t h = seed ^ size;
+    std::size_t   i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        std::uint64_t w;
+        std::memcpy(&w, data + i, 8);
+        h = (h ^ w) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 29;
+    }
+
+    for (; i < size; ++i)
+        h = (h ^ std::uint8_t(data[i])) * 0x100000001B3ULL;
+
+    return h;
+}
+
 }  // namespace Detail
 
 template<typename Arch, typename Transformer>
 Network<Arch, Transformer>::Network(const Network<Arch, Transformer>& other) :
     evalFile(other.evalFile),
-    embeddedType(other.embeddedType) {
+    embeddedType(other.embeddedType),
+    int8Weights(other.int8Weights) {
 
+    if (other.compressedWeights)
+        compressedWeights = make_unique_large_page<Compressed>(*other.compressedWeights);
+
+    // Copies are the NUMA replicas, made on their own node, so they get private
+    // weights even from shared ones: reading a single shared segment from every
+    // node would turn the replication into remote memory reads.
     if (other.featureTransformer)
         featureTransformer = make_unique_large_page<Transformer>(*other.featureTransformer);
 
@@ -131,11 +220,17 @@ Network<Arch, Transformer>&
 Network<Arch, Transformer>::operator=(const Network<Arch, Transformer>& other) {
     evalFile     = other.evalFile;
     embeddedType = other.embeddedType;
+    int8Weights  = other.int8Weights;
+
+    compressedWeights = other.compressedWeights
+                        ? make_unique_large_page<Compressed>(*other.compressedWeights)
+                        : nullptr;
 
     if (other.featureTransformer)
         featureTransformer = make_unique_large_page<Transformer>(*other.featureTransformer);
 
     network = make_unique_aligned<Arch[]>(LayerStacks);
+    sharedWeights.reset();
 
     if (!other.network)
         return *this;
@@ -147,7 +242,9 @@ Network<Arch, Transformer>::operator=(const Network<Arch, Transformer>& other) {
 }
 
 template<typename Arch, typename Transformer>
-void Network<Arch, Transformer>::load(const std::string& rootDirectory, std::string evalfilePath) {
+void Network<Arch, Transformer>::load(const std::string& rootDirectory,
+                                      std::string           evalfilePath,
+                                      const NetworkCaching& caching) {
 #if defined(DEFAULT_NNUE_DIRECTORY)
     std::vector<std::string> dirs = {"<internal>", "", rootDirectory,
                                      stringify(DEFAULT_NNUE_DIRECTORY)};
@@ -164,15 +261,32 @@ void Network<Arch, Transformer>::load(const std::string& rootDirectory, std::str
         {
             if (directory != "<internal>")
             {
-                load_user_net(directory, evalfilePath);
+                load_user_net(directory, evalfilePath, caching);
             }
 
             if (directory == "<internal>" && evalfilePath == evalFile.defaultName)
             {
-                load_internal();
+                load_internal(rootDirectory, caching);
             }
         }
     }
+
+    // The compressed copy must follow the weights that were just loaded
+    if (int8Weights)
+        use_int8_weights(true);
+}
+
+
+template<typename Arch, typename Transformer>
+std::size_t Network<Arch, Transformer>::use_int8_weights(bool enabled) {
+    int8Weights = enabled;
+    compressedWeights.reset();
+
+    if (!enabled || !featureTransformer)
+        return 0;
+
+    compressedWeights = make_unique_large_page<Compressed>();
+    return compressedWeights->build(*featureTransformer);
 }
 
 
@@ -222,12 +336,57 @@ Network<Arch, Transformer>::evaluate(const Position&                         pos
 
     const int  bucket = (pos.count<ALL_PIECES>() - 1) / 4;
     const auto psqt =
-      featureTransformer->transform(pos, accumulatorStack, cache, transformedFeatures, bucket);
+      featureTransformer->transform(pos, accumulatorStack, cache, compressedWeights.get(),
+                                    transformedFeatures, bucket);
     const auto positional = network[bucket].propagate(transformedFeatures);
     return {static_cast<Value>(psqt / OutputScale), static_cast<Value>(positional / OutputScale)};
 }
 
 
+template<typename Arch, typename Transformer>
+void Network<Arch, Transformer>::prefetch_weights(const Position& pos, const DirtyPiece& dp) const {
+
+    constexpr std::size_t PrefetchBytes = 4 * CacheLineSize;
+
+    for (Color perspective : {WHITE, BLACK})
+    {
+        // A refresh reads the rows that differ from the cached accumulator,
+        // they are not known here.
+        if (FeatureSet::requires_refresh(dp, perspective))
+            continue;
+
+        FeatureSet::IndexList removed, added;
+        const Square          ksq = pos.square<KING>(perspective);
+
+        if (perspective == WHITE)
+            FeatureSet::append_changed_indices<WHITE>(ksq, dp, removed, added);
+        else
+            FeatureSet::append_changed_indices<BLACK>(ksq, dp, removed, added);
+
+        // Only the start of each row is prefetched: it covers the latency of
+        // the first loads, the hardware prefetcher follows the rest of the row.
+        // Prefetching whole big net rows fills the line fill buffers instead.
+        auto prefetch_row = [&](IndexType index) {
+            const std::int8_t* row  = compressedWeights ? compressedWeights->row(index) : nullptr;
+            const char*        addr = row ? reinterpret_cast<const char*>(row)
+                                          : reinterpret_cast<const char*>(
+                                     &featureTransformer->weights[index * FTDimensions]);
+            const std::size_t  size = row ? FTDimensions : FTDimensions * sizeof(WeightType);
+
+            for (std::size_t i = 0; i < std::min(size, PrefetchBytes); i += CacheLineSize)
+                prefetch(addr + i);
+
+            prefetch(&featureTransformer->psqtWeights[index * PSQTBuckets]);
+        };
+
+        for (const auto index : removed)
+            prefetch_row(index);
+        for (const auto index : added)
+            prefetch_row(index);
+    }
+}
+
+
 template<typename Arch, typename Transformer>
 void Network<Arch, Transformer>::verify(std::string                                  evalfilePath,
                                         const std::function<void(std::string_view)>& f) const {
@@ -287,7 +446,8 @@ Network<Arch, Transformer>::trace_evaluate(const Position&
     for (IndexType bucket = 0; bucket < LayerStacks; ++bucket)
     {
         const auto materialist =
-          featureTransformer->transform(pos, accumulatorStack, cache, transformedFeatures, bucket);
+          featureTransformer->transform(pos, accumulatorStack, cache, compressedWeights.get(),
+                                        transformedFeatures, bucket);
         const auto positional = network[bucket].propagate(transformedFeatures);
 
         t.psqt[bucket]       = static_cast<Value>(materialist / OutputScale);
@@ -298,11 +458,62 @@ Network<Arch, Transformer>::trace_evaluate(const Position&
 }
 
 
+// With caching enabled, the network is taken from a shared memory segment or
+// a blob next to the file if one was made from the same file by a build with
+// the same weight layout. Otherwise the file is parsed as usual, and the blob
+// and the segment are (re)created for the next loads.
 template<typename Arch, typename Transformer>
-void Network<Arch, Transformer>::load_user_net(const std::string& dir,
-                                               const std::string& evalfilePath) {
+void Network<Arch, Transformer>::load_user_net(const std::string&    dir,
+                                               const std::string&    evalfilePath,
+                                               const NetworkCaching& caching) {
     std::ifstream stream(dir + evalfilePath, std::ios::binary);
-    auto          description = load(stream);
+
+    if (!caching.blobs && caching.sharedDirectory.empty())
+    {
+        auto description = load(stream);
+
+        if (description.has_value())
+        {
+            evalFile.current        = evalfilePath;
+            evalFile.netDescription = description.value();
+        }
+        return;
+    }
+
+    if (!stream.is_open())
+        return;
+
+    // The whole file is needed anyway to check it against the cached copies
+    stream.seekg(0, std::ios::end);
+    std::vector<char> data(size_t(std::max(std::streamoff(0), std::streamoff(stream.tellg()))));
+    stream.seekg(0, std::ios::beg);
+    stream.read(data.data(), std::streamsize(data.size()));
+
+    if (!stream)
+        return;
+
+    const std::uint64_t        sourceHash = Detail::hash_bytes(data.data(), data.size());
+    const std::string          blobPath   = dir + evalfilePath + "." + Detail::BlobArch + ".blob";
+    std::optional<std::string> description;
+    std::string                cachedDescription;
+
+    if ((!caching.sharedDirectory.empty()
+         && attach_shared(caching.sharedDirectory, sourceHash, cachedDescription))
+        || (caching.blobs && load_blob(blobPath, sourceHash, cachedDescription)))
+        description = cachedDescription;
+    else
+    {
+        MemoryBuffer buffer(data.data(), data.size());
+        std::istream memoryStream(&buffer);
+
+        description = load(memoryStream);
+
+        if (description.has_value() && caching.blobs)
+            save_blob(blobPath, sourceHash, description.value());
+    }
+
+    if (description.has_value() && !sharedWeights && !caching.sharedDirectory.empty())
+        publish_shared(caching.sharedDirectory, sourceHash, description.value());
 
     if (description.has_value())
     {
@@ -312,24 +523,58 @@ void Network<Arch, Transformer>::load_user_net(const std::string& dir,
 }
 
 
+namespace {
+
+// The blob of an embedded network is kept in the directory of the binary,
+// under the default name of the network. It is keyed by the hash of the
+// embedded data like any other blob, so a network file of that name with the
+// same contents shares it.
+std::string internal_blob_path(const std::string& rootDirectory, const std::string& defaultName) {
+    return rootDirectory + defaultName + "." + Detail::BlobArch + ".blob";
+}
+
+}  // namespace
+
+// The embedded networks are first loaded when the engine starts, before any
+// option can be set, so that load never uses the blob cache. Their blob serves
+// the later loads of an embedded network while the cache is enabled.
 template<typename Arch, typename Transformer>
-void Network<Arch, Transformer>::load_internal() {
-    // C++ way to prepare a buffer for a memory stream
-    class MemoryBuffer: public std::basic_streambuf<char> {
-       public:
-        MemoryBuffer(char* p, size_t n) {
-            setg(p, p, p + n);
-            setp(p, p + n);
-        }
-    };
+void Network<Arch, Transformer>::load_internal(const std::string&    rootDirectory,
+                                               const NetworkCaching& caching) {
 
     const auto embedded = get_embedded(embeddedType);
 
-    MemoryBuffer buffer(const_cast<char*>(reinterpret_cast<const char*>(embedded.data)),
-                        size_t(embedded.size));
+    std::optional<std::string> description;
+    std::uint64_t              sourceHash = 0;
+    std::string                cachedDescription;
+    const std::string          blobPath = internal_blob_path(rootDirectory, evalFile.defaultName);
+    const bool                 useBlob  = caching.blobs;
+
+    if (useBlob || !caching.sharedDirectory.empty())
+    {
+        sourceHash = Detail::hash_bytes(reinterpret_cast<const char*>(embedded.data),
+                                        size_t(embedded.size));
+
+        if ((!caching.sharedDirectory.empty()
+             && attach_shared(caching.sharedDirectory, sourceHash, cachedDescription))
+            || (useBlob && load_blob(blobPath, sourceHash, cachedDescription)))
+            description = cachedDescription;
+    }
+
+    if (!description.has_value())
+    {
+        MemoryBuffer buffer(const_cast<char*>(reinterpret_cast<const char*>(embedded.data)),
+                            size_t(embedded.size));
+
+        std::istream stream(&buffer);
+        description = load(stream);
+
+        if (description.has_value() && useBlob)
+            save_blob(blobPath, sourceHash, description.value());
+    }
 
-    std::istream stream(&buffer);
-    auto         description = load(stream);
+    if (description.has_value() && !sharedWeights && !caching.sharedDirectory.empty())
+        publish_shared(caching.sharedDirectory, sourceHash, description.value());
 
     if (description.has_value())
     {
@@ -338,11 +583,42 @@ void Network<Arch, Transformer>::load_internal() {
     }
 }
 
+template<typename Arch, typename Transformer>
+void Network<Arch, Transformer>::save_internal_blob(const std::string& rootDirectory) const {
+
+    if (evalFile.current != evalFile.defaultName || !featureTransformer)
+        return;
+
+    const auto embedded = get_embedded(embeddedType);
+
+    // A build without embedded networks only has a placeholder byte
+    if (embedded.size <= 1)
+        return;
+
+    save_blob(internal_blob_path(rootDirectory, evalFile.defaultName),
+              Detail::hash_bytes(reinterpret_cast<const char*>(embedded.data),
+                                 size_t(embedded.size)),
+              evalFile.netDescription);
+}
+
+
+// Points the network to weights in a shared memory segment, kept mapped by
+// the given mapping for as long as the network or one of its replicas uses it
+template<typename Arch, typename Transformer>
+void Network<Arch, Transformer>::use_shared(Transformer*                transformer,
+                                            Arch*                       arch,
+                                            std::shared_ptr<const void> mapping) {
+    featureTransformer = TransformerPtr(transformer, typename TransformerPtr::deleter_type(false));
+    network            = ArchPtr(arch, typename ArchPtr::deleter_type(false));
+    sharedWeights      = std::move(mapping);
+}
+
 
 template<typename Arch, typename Transformer>
 void Network<Arch, Transformer>::initialize() {
     featureTransformer = make_unique_large_page<Transformer>();
     network            = make_unique_aligned<Arch[]>(LayerStacks);
+    sharedWeights.reset();
 }
 
 
@@ -421,7 +697,15 @@ bool Network<Arch, Transformer>::write_parameters(std::ostream&      stream,
                                                   const std::string& netDescription) const {
     if (!write_header(stream, Network::hash, netDescription))
         return false;
-    if (!Detail::write_parameters(stream, *featureTransformer))
+
+    // Writing permutes the weights in place, shared weights are read-only
+    if (sharedWeights)
+    {
+        auto copy = make_unique_large_page<Transformer>(*featureTransformer);
+        if (!Detail::write_parameters(stream, *copy))
+            return false;
+    }
+    else if (!Detail::write_parameters(stream, *featureTransformer))
         return false;
     for (std::size_t i = 0; i < LayerStacks; ++i)
     {
@@ -431,6 +715,261 @@ bool Network<Arch, Transformer>::write_parameters(std::ostream&      stream,
     return bool(stream);
 }
 
+// Hash of what a blob stores: the description and the weights in memory layout
+template<typename Arch, typename Transformer>
+std::uint64_t Network<Arch, Transformer>::payload_hash(const std::string& netDescription) const {
+
+    std::uint64_t h = Detail::hash_bytes(netDescription.data(), netDescription.size());
+    h = Detail::hash_bytes(reinterpret_cast<const char*>(featureTransformer.get()),
+                           sizeof(Transformer), h);
+    return Detail::hash_bytes(reinterpret_cast<const char*>(network.get()),
+                              sizeof(Arch) * LayerStacks, h);
+}
+
+// Reads a blob written by save_blob(). Returns false if there is no blob
+// for this source file and weight layout, or if its payload was altered.
+template<typename Arch, typename Transformer>
+bool Network<Arch, Transformer>::load_blob(const std::string& path,
+                                           std::uint64_t      sourceHash,
+                                           std::string&       netDescription) {
+
+    static_assert(std::is_trivially_copyable_v<Transformer> && std::is_trivially_copyable_v<Arch>);
+
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open())
+        return false;
+
+    std::uint32_t header[5];
+    std::uint64_t hashValue, payloadHash;
+    std::uint32_t size;
+
+    stream.read(reinterpret_cast<char*>(header), sizeof(header));
+    stream.read(reinterpret_cast<char*>(&hashValue), sizeof(hashValue));
+    stream.read(reinterpret_cast<char*>(&payloadHash), sizeof(payloadHash));
+    stream.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+    if (!stream || header[0] != Detail::BlobMagic || header[1] != Network::hash
+        || header[2] != Detail::BlobLayout || header[3] != sizeof(Transformer)
+        || header[4] != sizeof(Arch) || hashValue != sourceHash)
+        return false;
+
+    initialize();
+    netDescription.resize(size);
+    stream.read(&netDescription[0], size);
+    stream.read(reinterpret_cast<char*>(featureTransformer.get()), sizeof(Transformer));
+    stream.read(reinterpret_cast<char*>(network.get()), sizeof(Arch) * LayerStacks);
+
+    // A blob that does not match its hash leaves the weights to be parsed again
+    return stream && stream.peek() == std::ios::traits_type::eof()
+        && payload_hash(netDescription) == payloadHash;
+}
+
+
+// Writes the loaded network as a blob. The file is written under a temporary
+// name and renamed, so that concurrently starting engines never read a partial
+// blob. Failures are not fatal, the network is then parsed again next time.
+template<typename Arch, typename Transformer>
+void Network<Arch, Transformer>::save_blob(const std::string& path,
+                                           std::uint64_t      sourceHash,
+                                           const std::string& netDescription) const {
+
+    const std::string tmpPath =
+      path + ".tmp" + std::to_string(now()) + "-" + std::to_string(uintptr_t(&tmpPath) & 0xFFFFF);
+
+    std::ofstream stream(tmpPath, std::ios::binary);
+    if (!stream.is_open())
+        return;
+
+    const std::uint32_t header[] = {Detail::BlobMagic, Network::hash, Detail::BlobLayout,
+                                    std::uint32_t(sizeof(Transformer)),
+                                    std::uint32_t(sizeof(Arch))};
+    const std::uint64_t payloadHash = payload_hash(netDescription);
+    const std::uint32_t size        = std::uint32_t(netDescription.size());
+
+    stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(&sourceHash), sizeof(sourceHash));
+    stream.write(reinterpret_cast<const char*>(&payloadHash), sizeof(payloadHash));
+    stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    stream.write(netDescription.data(), size);
+    stream.write(reinterpret_cast<const char*>(featureTransformer.get()), sizeof(Transformer));
+    stream.write(reinterpret_cast<const char*>(network.get()), sizeof(Arch) * LayerStacks);
+    stream.close();
+
+    if (!stream || std::rename(tmpPath.c_str(), path.c_str()))
+        std::remove(tmpPath.c_str());
+}
+
+namespace {
+
+// Shared memory segments hold a SharedHeader, the network description and
+// the weights in memory layout, at offsets aligned for the weight types. The
+// header is written last by the creator and checked by every attaching engine.
+// Segments are built under a temporary name and renamed into place once
+// complete, so that a creator that dies halfway leaves no segment behind that
+// would block the others.
+struct SharedHeader {
+    std::uint64_t ready;
+    std::uint64_t sourceHash;
+    std::uint32_t hash, layout, transformerSize, archSize, descriptionSize, layerStacks;
+};
+
+constexpr std::uint64_t SharedReady = 0x52444E4E47555300;  // "SUGNNDR"
+
+// Segments are rounded up to the size of a 2 MB huge page, so that the same
+// code can create them on hugetlbfs.
+constexpr std::size_t SharedGranularity = 2 * 1024 * 1024;
+
+template<typename Arch, typename Transformer>
+struct SharedLayout {
+    static std::size_t align(std::size_t offset, std::size_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    explicit SharedLayout(std::size_t descriptionSize) {
+        transformer = align(sizeof(SharedHeader) + descriptionSize, alignof(Transformer));
+        arch        = align(transformer + sizeof(Transformer), alignof(Arch));
+        size        = align(arch + sizeof(Arch) * LayerStacks, SharedGranularity);
+    }
+
+    std::size_t transformer, arch, size;
+};
+
+template<std::uint32_t Hash>
+std::string shared_name(const std::string& dir, std::uint64_t sourceHash) {
+
+    std::stringstream ss;
+    ss << dir << "/sugar-nnue-" << Detail::BlobArch << "-" << std::hex << Hash << "-"
+       << sourceHash;
+    return ss.str();
+}
+
+}  // namespace
+
+// Maps the weights from the shared memory segment made by another engine from
+// the same network. Returns false if there is none or it is not complete yet.
+template<typename Arch, typename Transformer>
+bool Network<Arch, Transformer>::attach_shared(const std::string& dir,
+                                               std::uint64_t      sourceHash,
+                                               std::string&       netDescription) {
+#ifndef _WIN32
+    const std::string path = shared_name<Network::hash>(dir, sourceHash);
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat statbuf;
+    const bool  ok = !fstat(fd, &statbuf) && size_t(statbuf.st_size) >= sizeof(SharedHeader);
+    void*       base =
+      ok ? mmap(nullptr, size_t(statbuf.st_size), PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+
+    if (base == MAP_FAILED)
+        return false;
+
+    const size_t        mapped = size_t(statbuf.st_size);
+    const SharedHeader& header = *static_cast<const SharedHeader*>(base);
+
+    if (header.ready != SharedReady || header.sourceHash != sourceHash
+        || header.hash != Network::hash || header.layout != Detail::BlobLayout
+        || header.transformerSize != sizeof(Transformer) || header.archSize != sizeof(Arch)
+        || header.layerStacks != LayerStacks
+        || SharedLayout<Arch, Transformer>(header.descriptionSize).size != mapped)
+    {
+        munmap(base, mapped);
+        return false;
+    }
+
+    const SharedLayout<Arch, Transformer> layout(header.descriptionSize);
+    char*                                 data = static_cast<char*>(base);
+
+    netDescription.assign(data + sizeof(SharedHeader), header.descriptionSize);
+
+    use_shared(reinterpret_cast<Transformer*>(data + layout.transformer),
+               reinterpret_cast<Arch*>(data + layout.arch),
+               std::shared_ptr<const void>(
+                 base, [mapped](const void* p) { munmap(const_cast<void*>(p), mapped); }));
+
+    return true;
+#else
+    (void) dir;
+    (void) sourceHash;
+    (void) netDescription;
+    return false;
+#endif
+}
+
+
+// Copies the loaded weights to a new shared memory segment, then maps them
+// from there so that this engine does not keep a private copy either. If
+// another engine is creating the segment, the private copy is kept.
+template<typename Arch, typename Transformer>
+void Network<Arch, Transformer>::publish_shared(const std::string& dir,
+                                                std::uint64_t      sourceHash,
+                                                const std::string& netDescription) {
+#ifndef _WIN32
+    const std::string                     path    = shared_name<Network::hash>(dir, sourceHash);
+    const std::string                     tmpPath = path + ".tmp";
+    const SharedLayout<Arch, Transformer> layout(netDescription.size());
+
+    // The lock of the temporary file tells the creators apart, it is released
+    // when a creator dies and the next one then reuses the file
+    int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd == -1)
+        return;
+
+    if (flock(fd, LOCK_EX | LOCK_NB))
+    {
+        ::close(fd);
+        return;
+    }
+
+    void* base = ftruncate(fd, 0) || ftruncate(fd, off_t(layout.size))
+                 ? MAP_FAILED
+                 : mmap(nullptr, layout.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (base == MAP_FAILED)
+    {
+        ::unlink(tmpPath.c_str());
+        ::close(fd);
+        return;
+    }
+
+    char*        data = static_cast<char*>(base);
+    SharedHeader header{0,
+                        sourceHash,
+                        Network::hash,
+                        Detail::BlobLayout,
+                        std::uint32_t(sizeof(Transformer)),
+                        std::uint32_t(sizeof(Arch)),
+                        std::uint32_t(netDescription.size()),
+                        std::uint32_t(LayerStacks)};
+
+    std::memcpy(data, &header, sizeof(header));
+    std::memcpy(data + sizeof(SharedHeader), netDescription.data(), netDescription.size());
+    std::memcpy(data + layout.transformer, featureTransformer.get(), sizeof(Transformer));
+    std::memcpy(data + layout.arch, network.get(), sizeof(Arch) * LayerStacks);
+
+    // Mark the segment complete only once everything else is in place
+    std::atomic_thread_fence(std::memory_order_release);
+    reinterpret_cast<volatile SharedHeader*>(data)->ready = SharedReady;
+    munmap(base, layout.size);
+
+    // Also replaces an incomplete segment left by an older engine
+    if (std::rename(tmpPath.c_str(), path.c_str()))
+        ::unlink(tmpPath.c_str());
+
+    ::close(fd);
+
+    std::string description;
+    attach_shared(dir, sourceHash, description);
+#else
+    (void) dir;
+    (void) sourceHash;
+    (void) netDescription;
+#endif
+}
+
 // Explicit template instantiations
 
 template class Network<NetworkArchitecture<TransformedFeatureDimensionsBig, L2Big, L3Big>,
@@ -22,6 +22,7 @@
 #include <cstdint>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -49,6 +50,34 @@ enum class EmbeddedNNUEType {
 
 using NetworkOutput = std::tuple<Value, Value>;
 
+// How networks are cached across engine runs and processes
+struct NetworkCaching {
+    // Read and write preprocessed blobs next to the network files
+    bool blobs = false;
+    // Directory of the shared memory segments holding the weights, like
+    // /dev/shm or a hugetlbfs mount. Empty if the weights are not shared.
+    std::string sharedDirectory;
+};
+
+// Deleter for weights that may live in a shared memory segment instead of an
+// allocation of their own. Such weights are released with the last mapping of
+// the segment, not by the pointer that refers to them.
+template<typename Deleter>
+struct WeightsDeleter {
+    WeightsDeleter() = default;
+    WeightsDeleter(const Deleter&) {}
+    explicit WeightsDeleter(bool isOwned) :
+        owned(isOwned) {}
+
+    template<typename T>
+    void operator()(T* ptr) const {
+        if (owned)
+            Deleter()(ptr);
+    }
+
+    bool owned = true;
+};
+
 template<typename Arch, typename Transformer>
 class Network {
     static constexpr IndexType FTDimensions = Arch::TransformedFeatureDimensions;
@@ -64,22 +93,34 @@ class Network {
     Network& operator=(const Network& other);
     Network& operator=(Network&& other) = default;
 
-    void load(const std::string& rootDirectory, std::string evalfilePath);
+    void load(const std::string& rootDirectory, std::string evalfilePath, const NetworkCaching&);
     bool save(const std::optional<std::string>& filename) const;
 
+    // Writes the blob of the embedded network, if it is the one in use, to
+    // the given directory, from where every later load of it reads it
+    void save_internal_blob(const std::string& rootDirectory) const;
+
+    // Uses int8 copies of the rows of the feature transformer weights that fit,
+    // also for the networks loaded later. Returns the number of such rows.
+    std::size_t use_int8_weights(bool enabled);
+
     NetworkOutput evaluate(const Position&                         pos,
                            AccumulatorStack&                       accumulatorStack,
                            AccumulatorCaches::Cache<FTDimensions>* cache) const;
 
 
+    // Prefetches the feature transformer rows that the accumulator update for
+    // the move that led to 'pos' will read
+    void prefetch_weights(const Position& pos, const DirtyPiece& dp) const;
+
     void verify(std::string evalfilePath, const std::function<void(std::string_view)>&) const;
     NnueEvalTrace trace_evaluate(const Position&                         pos,
                                  AccumulatorStack&                       accumulatorStack,
                                  AccumulatorCaches::Cache<FTDimensions>* cache) const;
 
    private:
-    void load_user_net(const std::string&, const std::string&);
-    void load_internal();
+    void load_user_net(const std::string&, const std::string&, const NetworkCaching&);
+    void load_internal(const std::string&, const NetworkCaching&);
 
     void initialize();
 
@@ -92,15 +133,36 @@ class Network {
     bool read_parameters(std::istream&, std::string&) const;
     bool write_parameters(std::ostream&, const std::string&) const;
 
+    bool load_blob(const std::string&, std::uint64_t, std::string&);
+    void save_blob(const std::string&, std::uint64_t, const std::string&) const;
+    std::uint64_t payload_hash(const std::string&) const;
+
+    bool attach_shared(const std::string&, std::uint64_t, std::string&);
+    void publish_shared(const std::string&, std::uint64_t, const std::string&);
+
+    using TransformerPtr = std::unique_ptr<Transformer, WeightsDeleter<LargePageDeleter<Transformer>>>;
+    using ArchPtr        = std::unique_ptr<Arch[], WeightsDeleter<AlignedArrayDeleter<Arch>>>;
+
+    void use_shared(Transformer*, Arch*, std::shared_ptr<const void>);
+
     // Input feature converter
-    LargePagePtr<Transformer> featureTransformer;
+    TransformerPtr featureTransformer;
 
     // Evaluation function
-    AlignedPtr<Arch[]> network;
+    ArchPtr network;
+
+    // Mapping of the shared memory segment holding the weights, if any
+    std::shared_ptr<const void> sharedWeights;
 
     EvalFile         evalFile;
     EmbeddedNNUEType embeddedType;
 
+    using Compressed = CompressedWeights<FTDimensions>;
+
+    // Private int8 copy of the feature transformer weights, if enabled
+    LargePagePtr<Compressed> compressedWeights;
+    bool                     int8Weights = false;
+
     // Hash value of evaluation function structure
     static constexpr std::uint32_t hash = Transformer::get_hash_value() ^ Arch::get_hash_value();
 
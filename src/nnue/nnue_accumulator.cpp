@@ -38,6 +38,7 @@ namespace {
 
 template<Color Perspective, IndexType TransformedFeatureDimensions>
 void double_inc_update(const FeatureTransformer<TransformedFeatureDimensions>& featureTransformer,
+                       const CompressedWeights<TransformedFeatureDimensions>*  compressed,
                        const Square                                            ksq,
                        AccumulatorState&                                       middle_state,
                        AccumulatorState&                                       target_state,
@@ -46,12 +47,14 @@ void double_inc_update(const FeatureTransformer<TransformedFeatureDimensions>& f
 template<Color Perspective, bool Forward, IndexType TransformedFeatureDimensions>
 void update_accumulator_incremental(
   const FeatureTransformer<TransformedFeatureDimensions>& featureTransformer,
+  const CompressedWeights<TransformedFeatureDimensions>*  compressed,
   const Square                                            ksq,
   AccumulatorState&                                       target_state,
   const AccumulatorState&                                 computed);
 
 template<Color Perspective, IndexType Dimensions>
 void update_accumulator_refresh_cache(const FeatureTransformer<Dimensions>& featureTransformer,
+                                      const CompressedWeights<Dimensions>*  compressed,
                                       const Position&                       pos,
                                       AccumulatorState&                     accumulatorState,
                                       AccumulatorCaches::Cache<Dimensions>& cache);
@@ -87,26 +90,31 @@ void AccumulatorStack::pop() noexcept {
 template<IndexType Dimensions>
 void AccumulatorStack::evaluate(const Position&                       pos,
                                 const FeatureTransformer<Dimensions>& featureTransformer,
+                                const CompressedWeights<Dimensions>*  compressed,
                                 AccumulatorCaches::Cache<Dimensions>& cache) noexcept {
 
-    evaluate_side<WHITE>(pos, featureTransformer, cache);
-    evaluate_side<BLACK>(pos, featureTransformer, cache);
+    evaluate_side<WHITE>(pos, featureTransformer, compressed, cache);
+    evaluate_side<BLACK>(pos, featureTransformer, compressed, cache);
 }
 
 template<Color Perspective, IndexType Dimensions>
 void AccumulatorStack::evaluate_side(const Position&                       pos,
                                      const FeatureTransformer<Dimensions>& featureTransformer,
+                                     const CompressedWeights<Dimensions>*  compressed,
                                      AccumulatorCaches::Cache<Dimensions>& cache) noexcept {
 
     const auto last_usable_accum = find_last_usable_accumulator<Perspective, Dimensions>();
 
     if ((accumulators[last_usable_accum].template acc<Dimensions>()).computed[Perspective])
-        forward_update_incremental<Perspective>(pos, featureTransformer, last_usable_accum);
+        forward_update_incremental<Perspective>(pos, featureTransformer, compressed,
+                                                last_usable_accum);
 
     else
     {
-        update_accumulator_refresh_cache<Perspective>(featureTransformer, pos, mut_latest(), cache);
-        backward_update_incremental<Perspective>(pos, featureTransformer, last_usable_accum);
+        update_accumulator_refresh_cache<Perspective>(featureTransformer, compressed, pos,
+                                                      mut_latest(), cache);
+        backward_update_incremental<Perspective>(pos, featureTransformer, compressed,
+                                                 last_usable_accum);
     }
 }
 
@@ -131,6 +139,7 @@ template<Color Perspective, IndexType Dimensions>
 void AccumulatorStack::forward_update_incremental(
   const Position&                       pos,
   const FeatureTransformer<Dimensions>& featureTransformer,
+  const CompressedWeights<Dimensions>*  compressed,
   const std::size_t                     begin) noexcept {
 
     assert(begin < accumulators.size());
@@ -149,8 +158,9 @@ void AccumulatorStack::forward_update_incremental(
             {
                 const Square captureSq = dp1.to;
                 dp1.to = dp2.remove_sq = SQ_NONE;
-                double_inc_update<Perspective>(featureTransformer, ksq, accumulators[next],
-                                               accumulators[next + 1], accumulators[next - 1]);
+                double_inc_update<Perspective>(featureTransformer, compressed, ksq,
+                                               accumulators[next], accumulators[next + 1],
+                                               accumulators[next - 1]);
                 dp1.to = dp2.remove_sq = captureSq;
 
                 next++;
@@ -158,7 +168,7 @@ void AccumulatorStack::forward_update_incremental(
             }
         }
         update_accumulator_incremental<Perspective, true>(
-          featureTransformer, ksq, accumulators[next], accumulators[next - 1]);
+          featureTransformer, compressed, ksq, accumulators[next], accumulators[next - 1]);
     }
 
     assert((latest().acc<Dimensions>()).computed[Perspective]);
@@ -168,6 +178,7 @@ template<Color Perspective, IndexType Dimensions>
 void AccumulatorStack::backward_update_incremental(
   const Position&                       pos,
   const FeatureTransformer<Dimensions>& featureTransformer,
+  const CompressedWeights<Dimensions>*  compressed,
   const std::size_t                     end) noexcept {
 
     assert(end < accumulators.size());
@@ -178,7 +189,7 @@ void AccumulatorStack::backward_update_incremental(
 
     for (std::int64_t next = std::int64_t(size) - 2; next >= std::int64_t(end); next--)
         update_accumulator_incremental<Perspective, false>(
-          featureTransformer, ksq, accumulators[next], accumulators[next + 1]);
+          featureTransformer, compressed, ksq, accumulators[next], accumulators[next + 1]);
 
     assert((accumulators[end].acc<Dimensions>()).computed[Perspective]);
 }
@@ -187,10 +198,12 @@ void AccumulatorStack::backward_update_incremental(
 template void AccumulatorStack::evaluate<TransformedFeatureDimensionsBig>(
   const Position&                                            pos,
   const FeatureTransformer<TransformedFeatureDimensionsBig>& featureTransformer,
+  const CompressedWeights<TransformedFeatureDimensionsBig>*  compressed,
   AccumulatorCaches::Cache<TransformedFeatureDimensionsBig>& cache) noexcept;
 template void AccumulatorStack::evaluate<TransformedFeatureDimensionsSmall>(
   const Position&                                              pos,
   const FeatureTransformer<TransformedFeatureDimensionsSmall>& featureTransformer,
+  const CompressedWeights<TransformedFeatureDimensionsSmall>*  compressed,
   AccumulatorCaches::Cache<TransformedFeatureDimensionsSmall>& cache) noexcept;
 
 
@@ -213,16 +226,36 @@ void fused_row_reduce(const ElementType* in, ElementType* out, const Ts* const..
           vecIn[i], reinterpret_cast<const typename VectorWrapper::type*>(rows)[i]...);
 }
 
+// Same as fused_row_reduce() for compressed int8 rows, widened on the fly
+template<IndexType Width,
+         UpdateOperation... ops,
+         typename... Ts,
+         std::enable_if_t<is_all_same_v<std::int8_t, Ts...>, bool> = true>
+void fused_row_reduce_widened(const BiasType* in, BiasType* out, const Ts* const... rows) {
+    using VecType              = Vec16Wrapper::type;
+    constexpr IndexType Lanes  = sizeof(VecType) / sizeof(BiasType);
+    constexpr IndexType size   = Width / Lanes;
+
+    auto* vecIn  = reinterpret_cast<const VecType*>(in);
+    auto* vecOut = reinterpret_cast<VecType*>(out);
+
+    for (IndexType i = 0; i < size; ++i)
+        vecOut[i] = fused<Vec16Wrapper, ops...>(vecIn[i], load_widened_weights(rows + i * Lanes)...);
+}
+
 template<Color Perspective, IndexType Dimensions>
 struct AccumulatorUpdateContext {
     const FeatureTransformer<Dimensions>& featureTransformer;
+    const CompressedWeights<Dimensions>*  compressed;
     const AccumulatorState&               from;
     AccumulatorState&                     to;
 
     AccumulatorUpdateContext(const FeatureTransformer<Dimensions>& ft,
+                             const CompressedWeights<Dimensions>*  cw,
                              const AccumulatorState&               accF,
                              AccumulatorState&                     accT) noexcept :
         featureTransformer{ft},
+        compressed{cw},
         from{accF},
         to{accT} {}
 
@@ -238,9 +271,14 @@ struct AccumulatorUpdateContext {
             return &featureTransformer.psqtWeights[index * PSQTBuckets];
         };
 
-        fused_row_reduce<Vec16Wrapper, Dimensions, ops...>(
-          (from.acc<Dimensions>()).accumulation[Perspective],
-          (to.acc<Dimensions>()).accumulation[Perspective], to_weight_vector(indices)...);
+        if (compressed && (compressed->fits[indices] && ...))
+            fused_row_reduce_widened<Dimensions, ops...>(
+              (from.acc<Dimensions>()).accumulation[Perspective],
+              (to.acc<Dimensions>()).accumulation[Perspective], compressed->row(indices)...);
+        else
+            fused_row_reduce<Vec16Wrapper, Dimensions, ops...>(
+              (from.acc<Dimensions>()).accumulation[Perspective],
+              (to.acc<Dimensions>()).accumulation[Perspective], to_weight_vector(indices)...);
 
         fused_row_reduce<Vec32Wrapper, PSQTBuckets, ops...>(
           (from.acc<Dimensions>()).psqtAccumulation[Perspective],
@@ -250,14 +288,16 @@ struct AccumulatorUpdateContext {
 
 template<Color Perspective, IndexType Dimensions>
 auto make_accumulator_update_context(const FeatureTransformer<Dimensions>& featureTransformer,
+                                     const CompressedWeights<Dimensions>*  compressed,
                                      const AccumulatorState&               accumulatorFrom,
                                      AccumulatorState&                     accumulatorTo) noexcept {
-    return AccumulatorUpdateContext<Perspective, Dimensions>{featureTransformer, accumulatorFrom,
-                                                             accumulatorTo};
+    return AccumulatorUpdateContext<Perspective, Dimensions>{featureTransformer, compressed,
+                                                             accumulatorFrom, accumulatorTo};
 }
 
 template<Color Perspective, IndexType TransformedFeatureDimensions>
 void double_inc_update(const FeatureTransformer<TransformedFeatureDimensions>& featureTransformer,
+                       const CompressedWeights<TransformedFeatureDimensions>*  compressed,
                        const Square                                            ksq,
                        AccumulatorState&                                       middle_state,
                        AccumulatorState&                                       target_state,
@@ -284,7 +324,8 @@ void double_inc_update(const FeatureTransformer<TransformedFeatureDimensions>& f
     sf_assume(removed.size() == 2 || removed.size() == 3);
 
     auto updateContext =
-      make_accumulator_update_context<Perspective>(featureTransformer, computed, target_state);
+      make_accumulator_update_context<Perspective>(featureTransformer, compressed, computed,
+                                                   target_state);
 
     if (removed.size() == 2)
     {
@@ -302,6 +343,7 @@ void double_inc_update(const FeatureTransformer<TransformedFeatureDimensions>& f
 template<Color Perspective, bool Forward, IndexType TransformedFeatureDimensions>
 void update_accumulator_incremental(
   const FeatureTransformer<TransformedFeatureDimensions>& featureTransformer,
+  const CompressedWeights<TransformedFeatureDimensions>*  compressed,
   const Square                                            ksq,
   AccumulatorState&                                       target_state,
   const AccumulatorState&                                 computed) {
@@ -334,7 +376,8 @@ void update_accumulator_incremental(
     sf_assume(removed.size() == 1 || removed.size() == 2);
 
     auto updateContext =
-      make_accumulator_update_context<Perspective>(featureTransformer, computed, target_state);
+      make_accumulator_update_context<Perspective>(featureTransformer, compressed, computed,
+                                                   target_state);
 
     if ((Forward && removed.size() == 1) || (!Forward && added.size() == 1))
     {
@@ -363,6 +406,7 @@ void update_accumulator_incremental(
 
 template<Color Perspective, IndexType Dimensions>
 void update_accumulator_refresh_cache(const FeatureTransformer<Dimensions>& featureTransformer,
+                                      const CompressedWeights<Dimensions>*  compressed,
                                       const Position&                       pos,
                                       AccumulatorState&                     accumulatorState,
                                       AccumulatorCaches::Cache<Dimensions>& cache) {
@@ -412,6 +456,54 @@ void update_accumulator_refresh_cache(const FeatureTransformer<Dimensions>& feat
         for (IndexType k = 0; k < Tiling::NumRegs; ++k)
             acc[k] = entryTile[k];
 
+        if (compressed)
+        {
+            // Rows are not paired here, as they may come from either weights
+            constexpr IndexType Lanes = sizeof(vec_t) / sizeof(WeightType);
+
+            for (const auto index : removed)
+            {
+                const IndexType offset = Dimensions * index + j * Tiling::TileHeight;
+
+                if (const std::int8_t* row = compressed->row(index))
+                    for (IndexType k = 0; k < Tiling::NumRegs; ++k)
+                        acc[k] = vec_sub_16(
+                          acc[k], load_widened_weights(row + j * Tiling::TileHeight + k * Lanes));
+                else
+                {
+                    auto* column =
+                      reinterpret_cast<const vec_t*>(&featureTransformer.weights[offset]);
+
+                    for (IndexType k = 0; k < Tiling::NumRegs; ++k)
+                        acc[k] = vec_sub_16(acc[k], column[k]);
+                }
+            }
+            for (const auto index : added)
+            {
+                const IndexType offset = Dimensions * index + j * Tiling::TileHeight;
+
+                if (const std::int8_t* row = compressed->row(index))
+                    for (IndexType k = 0; k < Tiling::NumRegs; ++k)
+                        acc[k] = vec_add_16(
+                          acc[k], load_widened_weights(row + j * Tiling::TileHeight + k * Lanes));
+                else
+                {
+                    auto* column =
+                      reinterpret_cast<const vec_t*>(&featureTransformer.weights[offset]);
+
+                    for (IndexType k = 0; k < Tiling::NumRegs; ++k)
+                        acc[k] = vec_add_16(acc[k], column[k]);
+                }
+            }
+
+            for (IndexType k = 0; k < Tiling::NumRegs; k++)
+                vec_store(&entryTile[k], acc[k]);
+            for (IndexType k = 0; k < Tiling::NumRegs; k++)
+                vec_store(&accTile[k], acc[k]);
+
+            continue;
+        }
+
         IndexType i = 0;
         for (; i < std::min(removed.size(), added.size()); ++i)
         {
@@ -489,6 +581,9 @@ void update_accumulator_refresh_cache(const FeatureTransformer<Dimensions>& feat
 
 #else
 
+    // The compressed weights would not save anything without vector loads
+    (void) compressed;
+
     for (const auto index : removed)
     {
         const IndexType offset = Dimensions * index;
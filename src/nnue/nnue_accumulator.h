@@ -21,6 +21,7 @@
 #ifndef NNUE_ACCUMULATOR_H_INCLUDED
 #define NNUE_ACCUMULATOR_H_INCLUDED
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdint>
@@ -43,6 +44,9 @@ struct alignas(CacheLineSize) Accumulator;
 template<IndexType TransformedFeatureDimensions>
 class FeatureTransformer;
 
+template<IndexType TransformedFeatureDimensions>
+struct CompressedWeights;
+
 // Class that holds the result of affine transformation of input features
 template<IndexType Size>
 struct alignas(CacheLineSize) Accumulator {
@@ -106,6 +110,52 @@ struct AccumulatorCaches {
     Cache<TransformedFeatureDimensionsSmall> small;
 };
 
+// EvalCache keeps the network outputs (psqt, positional) of recently
+// evaluated positions, one table per network, so that a transposition does
+// not need another forward pass. Tables are indexed by the position key and
+// owned by a single thread, so no synchronization is needed.
+struct EvalCache {
+
+    struct Entry {
+        Key          key;
+        std::int32_t psqt;
+        std::int32_t positional;
+    };
+
+    // Resizes both tables to share mbSize MB, a size of zero disables the cache
+    void resize(std::size_t mbSize) {
+
+        std::size_t count = mbSize * 1024 * 1024 / (2 * sizeof(Entry));
+
+        // Round down to a power of two to index the tables with a mask
+        while (count & (count - 1))
+            count &= count - 1;
+
+        if (count != big.size())
+        {
+            big   = std::vector<Entry>(count);
+            small = std::vector<Entry>(count);
+        }
+    }
+
+    void clear() {
+        std::fill(big.begin(), big.end(), Entry{});
+        std::fill(small.begin(), small.end(), Entry{});
+        lookups = hits = 0;
+    }
+
+    bool enabled() const { return !big.empty(); }
+
+    template<bool Big>
+    Entry& entry(Key key) {
+        auto& table = Big ? big : small;
+        return table[key & (table.size() - 1)];
+    }
+
+    std::vector<Entry> big, small;
+    std::uint64_t      lookups = 0, hits = 0;
+};
+
 
 struct AccumulatorState {
     Accumulator<TransformedFeatureDimensionsBig>   accumulatorBig;
@@ -155,6 +205,7 @@ class AccumulatorStack {
     template<IndexType Dimensions>
     void evaluate(const Position&                       pos,
                   const FeatureTransformer<Dimensions>& featureTransformer,
+                  const CompressedWeights<Dimensions>*  compressed,
                   AccumulatorCaches::Cache<Dimensions>& cache) noexcept;
 
    private:
@@ -163,6 +214,7 @@ class AccumulatorStack {
     template<Color Perspective, IndexType Dimensions>
     void evaluate_side(const Position&                       pos,
                        const FeatureTransformer<Dimensions>& featureTransformer,
+                       const CompressedWeights<Dimensions>*  compressed,
                        AccumulatorCaches::Cache<Dimensions>& cache) noexcept;
 
     template<Color Perspective, IndexType Dimensions>
@@ -171,11 +223,13 @@ class AccumulatorStack {
     template<Color Perspective, IndexType Dimensions>
     void forward_update_incremental(const Position&                       pos,
                                     const FeatureTransformer<Dimensions>& featureTransformer,
+                                    const CompressedWeights<Dimensions>*  compressed,
                                     const std::size_t                     begin) noexcept;
 
     template<Color Perspective, IndexType Dimensions>
     void backward_update_incremental(const Position&                       pos,
                                      const FeatureTransformer<Dimensions>& featureTransformer,
+                                     const CompressedWeights<Dimensions>*  compressed,
                                      const std::size_t                     end) noexcept;
 
     std::vector<AccumulatorState> accumulators;
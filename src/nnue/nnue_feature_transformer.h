@@ -171,16 +171,18 @@ class FeatureTransformer {
         return !stream.fail();
     }
 
-    // Convert input features
+    // Convert input features, reading the weights from 'compressed' where
+    // it has them, if not null
     std::int32_t transform(const Position&                           pos,
                            AccumulatorStack&                         accumulatorStack,
                            AccumulatorCaches::Cache<HalfDimensions>* cache,
+                           const CompressedWeights<HalfDimensions>*  compressed,
                            OutputType*                               output,
                            int                                       bucket) const {
 
         using namespace SIMD;
 
-        accumulatorStack.evaluate(pos, *this, *cache);
+        accumulatorStack.evaluate(pos, *this, compressed, *cache);
         const auto& accumulatorState = accumulatorStack.latest();
 
         const Color perspectives[2]  = {pos.side_to_move(), ~pos.side_to_move()};
@@ -307,6 +309,48 @@ class FeatureTransformer {
     alignas(CacheLineSize) PSQTWeightType psqtWeights[InputDimensions * PSQTBuckets];
 };
 
+// Copy of the feature transformer weights with the rows whose weights fit in
+// int8 before the load time scaling stored as int8, which halves the memory
+// traffic of the accumulator updates using them. The kernels widen and double
+// these rows on the fly and keep using the int16 weights for the other rows,
+// so the evaluation is exactly the same.
+template<IndexType HalfDimensions>
+struct CompressedWeights {
+    static constexpr IndexType InputDimensions = FeatureSet::Dimensions;
+
+    // Compresses the rows of the given weights that fit, returns their number
+    IndexType build(const FeatureTransformer<HalfDimensions>& featureTransformer) {
+        IndexType count = 0;
+
+        for (IndexType j = 0; j < InputDimensions; ++j)
+        {
+            const WeightType* w = &featureTransformer.weights[j * HalfDimensions];
+
+            fits[j] = std::all_of(w, w + HalfDimensions, [](WeightType v) {
+                return v % 2 == 0 && v / 2 >= -128 && v / 2 <= 127;
+            });
+
+            if (!fits[j])
+                continue;
+
+            for (IndexType i = 0; i < HalfDimensions; ++i)
+                weights[j * HalfDimensions + i] = std::int8_t(w[i] / 2);
+
+            ++count;
+        }
+
+        return count;
+    }
+
+    // Returns the compressed row of the feature, or nullptr if it has none
+    const std::int8_t* row(IndexType index) const {
+        return fits[index] ? &weights[index * HalfDimensions] : nullptr;
+    }
+
+    alignas(CacheLineSize) std::int8_t weights[HalfDimensions * InputDimensions];
+    bool fits[InputDimensions];
+};
+
 }  // namespace Sugar::Eval::NNUE
 
 #endif  // #ifndef NNUE_FEATURE_TRANSFORMER_H_INCLUDED
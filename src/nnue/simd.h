@@ -220,6 +220,28 @@ struct Vec32Wrapper {
 #endif
 };
 
+// Loads the int8 weights of one Vec16Wrapper::type, sign extended to int16 and
+// doubled like the feature transformer weights are at load time.
+inline Vec16Wrapper::type load_widened_weights(const std::int8_t* p) {
+#if defined(USE_AVX512)
+    return _mm512_slli_epi16(
+      _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))), 1);
+#elif defined(USE_AVX2)
+    return _mm256_slli_epi16(
+      _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))), 1);
+#elif defined(USE_SSE41)
+    return _mm_slli_epi16(_mm_cvtepi8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))),
+                          1);
+#elif defined(USE_SSE2)
+    const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    return _mm_slli_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8), 1);
+#elif defined(USE_NEON)
+    return vshlq_n_s16(vmovl_s8(vld1_s8(p)), 1);
+#else
+    return BiasType(*p * 2);
+#endif
+}
+
 enum UpdateOperation {
     Add,
     Sub
@@ -813,6 +813,72 @@ class NumaConfig {
         return ns;
     }
 
+    // Returns the processors ordered to place threads on distinct physical cores
+    // before using SMT siblings: one processor of every core, then a second one
+    // of every core that has more, and so on. Cores are identified by their
+    // sibling list in the Linux sysfs topology. Elsewhere, or when the topology
+    // cannot be read, the result is empty.
+    std::vector<CpuIndex> cpus_by_physical_core() const {
+        std::vector<CpuIndex> result;
+
+#if defined(__linux__) && !defined(__ANDROID__)
+
+        std::vector<std::vector<CpuIndex>> cores;
+        std::map<std::string, size_t>      coreBySiblings;
+        size_t                             cpuCount = 0;
+
+        for (auto&& cpus : nodes)
+            for (CpuIndex c : cpus)
+            {
+                auto siblings = read_file_to_string("/sys/devices/system/cpu/cpu"
+                                                    + std::to_string(c)
+                                                    + "/topology/thread_siblings_list");
+                if (!siblings.has_value())
+                    return {};
+
+                remove_whitespace(*siblings);
+
+                auto [it, inserted] = coreBySiblings.try_emplace(*siblings, cores.size());
+                if (inserted)
+                    cores.emplace_back();
+
+                cores[it->second].push_back(c);
+                ++cpuCount;
+            }
+
+        for (size_t sibling = 0; result.size() < cpuCount; ++sibling)
+            for (auto&& core : cores)
+                if (sibling < core.size())
+                    result.push_back(core[sibling]);
+
+#endif
+
+        return result;
+    }
+
+    // Restricts the current thread to a single processor. Unlike the NUMA node
+    // binding this is only a placement hint, so a failure is ignored.
+    void bind_current_thread_to_cpu([[maybe_unused]] CpuIndex c) const {
+#if defined(__linux__) && !defined(__ANDROID__)
+
+        cpu_set_t* mask = CPU_ALLOC(highestCpuIndex + 1);
+        if (mask == nullptr)
+            return;
+
+        const size_t masksize = CPU_ALLOC_SIZE(highestCpuIndex + 1);
+
+        CPU_ZERO_S(masksize, mask);
+        CPU_SET_S(c, masksize, mask);
+
+        sched_setaffinity(0, masksize, mask);
+
+        CPU_FREE(mask);
+
+        sched_yield();
+
+#endif
+    }
+
     NumaReplicatedAccessToken bind_current_thread_to_numa_node(NumaIndex n) const {
         if (n >= nodes.size() || nodes[n].size() == 0)
             std::exit(EXIT_FAILURE);
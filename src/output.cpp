@@ -0,0 +1,315 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "output.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+
+#include "misc.h"
+#include "uci.h"
+
+namespace Sugar {
+
+namespace {
+
+// MultiPV is limited to 256 lines, index 0 is unused
+constexpr size_t MaxMultiPV = 256;
+
+}
+
+AsyncOutput::AsyncOutput() = default;
+
+AsyncOutput::~AsyncOutput() {
+
+    if (!writer.joinable())
+        return;
+
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        quit = true;
+    }
+    cv.notify_one();
+    writer.join();
+}
+
+void AsyncOutput::set_enabled(bool value) {
+
+    if (value && !writer.joinable())
+    {
+        ring.resize(Capacity);
+        writer = std::thread(&AsyncOutput::idle_loop, this);
+    }
+
+    // Switching back to direct printing must not overtake queued records
+    if (!value)
+        flush();
+
+    isEnabled = value;
+}
+
+// The string views of a record point to its own strings, which move with it
+void AsyncOutput::copy_record(Record& to, const Record& from) {
+
+    to.kind           = from.kind;
+    to.info           = from.info;
+    to.currmovenumber = from.currmovenumber;
+    to.pv.assign(from.pv);
+    to.bound.assign(from.bound);
+    to.wdl.assign(from.wdl);
+    to.move.assign(from.move);
+    to.ponder.assign(from.ponder);
+    to.info.pv    = to.pv;
+    to.info.bound = to.bound;
+    to.info.wdl   = to.wdl;
+}
+
+// Returns the next free slot, or nullptr if the ring is full. The records
+// that did not fit before are queued first, so that the order is kept.
+// Records which must reach the GUI (bestmove and the info sent when there
+// are no legal moves) wait for the writer, and for the backlog to be queued,
+// they are only pushed once the search is over.
+AsyncOutput::Record* AsyncOutput::acquire_slot(bool mustDeliver) {
+
+    size_t queued = 0;
+
+    while (true)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+
+        if (h - tail.load(std::memory_order_acquire) >= Capacity)
+        {
+            if (!mustDeliver)
+                break;
+
+            std::this_thread::yield();
+            continue;
+        }
+
+        if (queued == backlog.size())
+        {
+            backlog.clear();
+            return &ring[h & (Capacity - 1)];
+        }
+
+        copy_record(ring[h & (Capacity - 1)], backlog[queued++]);
+        publish();
+    }
+
+    backlog.erase(backlog.begin(), backlog.begin() + queued);
+    return nullptr;
+}
+
+// Keeps an update that found the ring full until there is room for it. Only
+// the newest full info line per MultiPV index and the newest currmove line
+// are kept: the older ones would be coalesced by the writer anyway, and the
+// last PV before bestmove must not be lost.
+AsyncOutput::Record& AsyncOutput::backlog_slot(Kind kind, size_t multiPV) {
+
+    auto it = std::find_if(backlog.begin(), backlog.end(), [&](const Record& r) {
+        return r.kind == kind && (kind != Kind::UpdateFull || r.info.multiPV == multiPV);
+    });
+
+    if (it != backlog.end())
+    {
+        backlog.erase(it);
+        droppedCnt.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return backlog.emplace_back();
+}
+
+void AsyncOutput::publish() {
+
+    head.store(head.load(std::memory_order_relaxed) + 1);
+
+    // The writer announces that it is about to sleep before it checks for new
+    // records, so either it sees this record or we see it waiting. The lock is
+    // only held by the writer while it checks, never while it prints.
+    if (waiting.load())
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        cv.notify_one();
+    }
+}
+
+void AsyncOutput::push(const Search::InfoFull& info) {
+
+    Record*    r      = acquire_slot(false);
+    const bool queued = r != nullptr;
+
+    if (!queued)
+        r = &backlog_slot(Kind::UpdateFull, info.multiPV);
+
+    r->kind = Kind::UpdateFull;
+    r->info = info;
+    r->pv.assign(info.pv);
+    r->bound.assign(info.bound);
+    r->wdl.assign(info.wdl);
+    r->info.pv    = r->pv;
+    r->info.bound = r->bound;
+    r->info.wdl   = r->wdl;
+
+    if (queued)
+        publish();
+}
+
+void AsyncOutput::push(const Search::InfoShort& info) {
+
+    Record* r = acquire_slot(true);
+
+    r->kind       = Kind::UpdateNoMoves;
+    r->info.depth = info.depth;
+    r->info.score = info.score;
+
+    publish();
+}
+
+void AsyncOutput::push(const Search::InfoIteration& info) {
+
+    Record*    r      = acquire_slot(false);
+    const bool queued = r != nullptr;
+
+    if (!queued)
+        r = &backlog_slot(Kind::Iter, 0);
+
+    r->kind       = Kind::Iter;
+    r->info.depth = info.depth;
+    r->move.assign(info.currmove);
+    r->currmovenumber = info.currmovenumber;
+
+    if (queued)
+        publish();
+}
+
+void AsyncOutput::push_bestmove(std::string_view bestmove, std::string_view ponder) {
+
+    Record* r = acquire_slot(true);
+
+    r->kind = Kind::Bestmove;
+    r->move.assign(bestmove);
+    r->ponder.assign(ponder);
+
+    publish();
+}
+
+void AsyncOutput::flush() const {
+
+    while (tail.load(std::memory_order_acquire) != head.load(std::memory_order_acquire))
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+void AsyncOutput::idle_loop() {
+
+    while (true)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+
+        if (t == h)
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            waiting = true;
+            cv.wait(lk, [&] { return quit || head.load() != t; });
+            waiting = false;
+
+            if (quit)
+                return;
+
+            continue;
+        }
+
+        write_batch(t, h);
+        tail.store(h, std::memory_order_release);
+    }
+}
+
+// Formats and prints the records in [first, last). Walking backwards, a full
+// info line is stale if a newer one for the same MultiPV index follows it
+// before the next bestmove, and so is every currmove line but the newest.
+void AsyncOutput::write_batch(size_t first, size_t last) {
+
+    std::vector<bool>                 stale(last - first);
+    std::array<bool, MaxMultiPV + 1> seen{};
+    bool                              iterSeen = false;
+
+    for (size_t i = last; i-- > first;)
+    {
+        const Record& r = ring[i & (Capacity - 1)];
+
+        if (r.kind == Kind::UpdateFull)
+        {
+            const size_t idx = std::min(r.info.multiPV, MaxMultiPV);
+            stale[i - first] = seen[idx];
+            seen[idx]        = true;
+        }
+        else if (r.kind == Kind::Iter)
+        {
+            stale[i - first] = iterSeen;
+            iterSeen         = true;
+        }
+        else
+        {
+            seen.fill(false);
+            iterSeen = false;
+        }
+    }
+
+    buffer.clear();
+    size_t coalesced = 0;
+
+    for (size_t i = first; i < last; ++i)
+    {
+        if (stale[i - first])
+        {
+            ++coalesced;
+            continue;
+        }
+
+        const Record& r = ring[i & (Capacity - 1)];
+
+        switch (r.kind)
+        {
+        case Kind::UpdateFull :
+            buffer += UCIEngine::format_update_full(r.info);
+            break;
+        case Kind::UpdateNoMoves :
+            buffer += UCIEngine::format_update_no_moves(r.info);
+            break;
+        case Kind::Iter :
+            buffer += UCIEngine::format_iter({r.info.depth, r.move, r.currmovenumber});
+            break;
+        case Kind::Bestmove :
+            buffer += UCIEngine::format_bestmove(r.move, r.ponder);
+            break;
+        }
+        buffer += '\n';
+    }
+
+    coalescedCnt.fetch_add(coalesced, std::memory_order_relaxed);
+
+    sync_cout_start();
+    std::cout << buffer << std::flush;
+    sync_cout_end();
+}
+
+}  // namespace Sugar
@@ -0,0 +1,110 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OUTPUT_H_INCLUDED
+#define OUTPUT_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "search.h"
+
+namespace Sugar {
+
+// AsyncOutput moves the formatting and printing of the search output off the
+// main search thread. The search thread copies each update into a slot of a
+// bounded single-producer/single-consumer ring and returns immediately, a
+// dedicated thread formats the records and writes them to stdout in batches.
+// When the writer falls behind, full info lines that were superseded by a
+// newer line for the same MultiPV index are dropped instead of printed, and
+// when the ring is full the older lines make room for the newer ones.
+class AsyncOutput {
+   public:
+    AsyncOutput();
+    ~AsyncOutput();
+
+    AsyncOutput(const AsyncOutput&)            = delete;
+    AsyncOutput& operator=(const AsyncOutput&) = delete;
+
+    // Producer side, only called by the thread running the main search worker
+    void push(const Search::InfoFull& info);
+    void push(const Search::InfoShort& info);
+    void push(const Search::InfoIteration& info);
+    void push_bestmove(std::string_view bestmove, std::string_view ponder);
+
+    // Waits until all the records pushed so far have been written
+    void flush() const;
+
+    // Enables queued output, starting the writer thread on first use.
+    // Must not be called while a search is running.
+    void set_enabled(bool value);
+    bool enabled() const { return isEnabled; }
+
+    std::uint64_t coalesced() const { return coalescedCnt; }
+    std::uint64_t dropped() const { return droppedCnt; }
+
+   private:
+    enum class Kind : std::uint8_t {
+        UpdateFull,
+        UpdateNoMoves,
+        Iter,
+        Bestmove
+    };
+
+    // Owned copy of an update. The string views of the Info structs point to
+    // the caller's buffers, so their contents are copied into the strings
+    // below, whose capacity is reused across laps of the ring.
+    struct Record {
+        Kind             kind;
+        Search::InfoFull info;
+        size_t           currmovenumber;
+        std::string      pv, bound, wdl, move, ponder;
+    };
+
+    static constexpr size_t Capacity = 1024;  // Must be a power of two
+
+    static void copy_record(Record& to, const Record& from);
+
+    Record* acquire_slot(bool mustDeliver);
+    Record& backlog_slot(Kind kind, size_t multiPV);
+    void    publish();
+    void    idle_loop();
+    void    write_batch(size_t first, size_t last);
+
+    std::vector<Record>        ring;
+    std::vector<Record>        backlog;  // Producer only, updates that found the ring full
+    std::atomic<size_t>        head{0}, tail{0};
+    std::atomic<bool>          waiting{false}, quit{false};
+    std::atomic<std::uint64_t> coalescedCnt{0}, droppedCnt{0};
+    std::mutex                 mutex;
+    std::condition_variable    cv;
+    std::thread                writer;
+    bool                       isEnabled = false;
+    std::string                buffer;
+};
+
+}  // namespace Sugar
+
+#endif  // #ifndef OUTPUT_H_INCLUDED
@@ -20,6 +20,8 @@
 #define PERFT_H_INCLUDED
 
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 #include "movegen.h"
 #include "position.h"
@@ -62,6 +64,32 @@ inline uint64_t perft(const std::string& fen, Depth depth, bool isChess960) {
 
     return perft<true>(p, depth);
 }
+
+// Utility to measure move generation throughput. The moves of type T are
+// generated `iterations` times for every position where T applies, and the
+// total number of moves emitted is returned. A checksum of the generated moves
+// is accumulated so that the stores cannot be optimized away.
+template<GenType T>
+uint64_t movegen_count(const std::vector<std::unique_ptr<Position>>& positions,
+                       int                                           iterations,
+                       uint64_t&                                     checksum) {
+
+    uint64_t moves = 0;
+
+    for (int i = 0; i < iterations; ++i)
+        for (const auto& pos : positions)
+        {
+            if ((T == EVASIONS) != bool(pos->checkers()) && T != LEGAL)
+                continue;
+
+            MoveList<T> ml(*pos);
+            moves += ml.size();
+            if (ml.size())
+                checksum += ml.begin()[ml.size() - 1].raw();
+        }
+
+    return moves;
+}
 }
 
 #endif  // PERFT_H_INCLUDED
@@ -342,6 +342,25 @@ void Position::set_check_info() const {
 }
 
 
+// Computes the attack maps of color c for Position::threats()
+void Position::set_threats(Color c) const {
+
+    Bitboard* threats = st->threatsBy[c];
+
+    threats[PAWN]   = attacks_by<PAWN>(c);
+    threats[KNIGHT] = attacks_by<KNIGHT>(c);
+    threats[BISHOP] = attacks_by<BISHOP>(c);
+    threats[ROOK]   = attacks_by<ROOK>(c);
+    threats[QUEEN]  = attacks_by<QUEEN>(c);
+    threats[KING]   = attacks_bb<KING>(square<KING>(c));
+
+    threats[ALL_PIECES] = threats[PAWN] | threats[KNIGHT] | threats[BISHOP] | threats[ROOK]
+                        | threats[QUEEN] | threats[KING];
+
+    st->threatsReady |= 1 << c;
+}
+
+
 // Computes the hash keys of the position, and other
 // data that once computed is updated incrementally as moves are made.
 // The function is only used when a new position is set up
@@ -353,6 +372,7 @@ void Position::set_state() const {
     st->pawnKey                                   = Zobrist::noPawns;
     st->nonPawnMaterial[WHITE] = st->nonPawnMaterial[BLACK] = VALUE_ZERO;
     st->checkersBB = attackers_to(square<KING>(sideToMove)) & pieces(~sideToMove);
+    st->threatsReady = 0;
 
     set_check_info();
 
@@ -873,6 +893,9 @@ DirtyPiece Position::do_move(Move                      m,
     // Set capture piece
     st->capturedPiece = captured;
 
+    // Attack maps are recomputed on demand for the new position
+    st->threatsReady = 0;
+
     // Calculate checkers bitboard (if move gives check)
     st->checkersBB = givesCheck ? attackers_to(square<KING>(them)) & pieces(us) : 0;
 
@@ -1068,6 +1091,7 @@ void Position::do_null_move(StateInfo& newSt, const TranspositionTable& tt) {
     assert(!checkers());
     assert(&newSt != st);
 
+    // The board does not change, so the attack maps stay valid as well
     std::memcpy(&newSt, st, sizeof(StateInfo));
 
     newSt.previous = st;
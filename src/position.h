@@ -58,14 +58,19 @@ struct StateInfo {
     Bitboard   checkSquares[PIECE_TYPE_NB];
     Piece      capturedPiece;
     int        repetition;
+
+    // Computed on demand by Position::threats(), at most once per state
+    Bitboard threatsBy[COLOR_NB][PIECE_TYPE_NB];
+    int      threatsReady;
 };
 
 
 // A list to keep track of the position states along the setup moves (from the
 // start position to the position just before the search starts). Needed by
 // 'draw by repetition' detection. Use a std::deque because pointers to
-// elements are not invalidated upon list resizing.
-using StateListPtr = std::unique_ptr<std::deque<StateInfo>>;
+// elements are not invalidated upon list resizing. The list is shared by the
+// engine, which may append new moves to it, and the running search.
+using StateListPtr = std::shared_ptr<std::deque<StateInfo>>;
 
 
 // Position class stores information regarding the board representation as
@@ -120,6 +125,7 @@ class Position {
     void     update_slider_blockers(Color c) const;
     template<PieceType Pt>
     Bitboard attacks_by(Color c) const;
+    Bitboard threats(Color c, PieceType pt) const;
 
     // Properties of moves
     bool  legal(Move m) const;
@@ -173,6 +179,7 @@ class Position {
     void set_castling_right(Color c, Square rfrom);
     void set_state() const;
     void set_check_info() const;
+    void set_threats(Color c) const;
 
     // Other helpers
     void move_piece(Square from, Square to);
@@ -264,6 +271,8 @@ inline Bitboard Position::attacks_by(Color c) const {
     if constexpr (Pt == PAWN)
         return c == WHITE ? pawn_attacks_bb<WHITE>(pieces(WHITE, PAWN))
                           : pawn_attacks_bb<BLACK>(pieces(BLACK, PAWN));
+    else if constexpr (Pt == KNIGHT)
+        return knight_attacks_bb(pieces(c, KNIGHT));
     else
     {
         Bitboard threats   = 0;
@@ -274,6 +283,16 @@ inline Bitboard Position::attacks_by(Color c) const {
     }
 }
 
+// Returns the squares attacked by the pieces of type pt of color c, or by all
+// pieces of color c when pt is ALL_PIECES. The attack maps of a color are
+// computed together on first use and kept in the StateInfo, so that move
+// ordering and pruning at the same node share them.
+inline Bitboard Position::threats(Color c, PieceType pt) const {
+    if (!(st->threatsReady & (1 << c)))
+        set_threats(c);
+    return st->threatsBy[c][pt];
+}
+
 inline Bitboard Position::checkers() const { return st->checkersBB; }
 
 inline Bitboard Position::blockers_for_king(Color c) const { return st->blockersForKing[c]; }
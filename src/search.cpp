@@ -32,6 +32,7 @@
 #include <list>
 #include <ratio>
 #include <string>
+#include <unordered_set>
 #include <utility>
 
 #if defined(SUG_FIXED_ZOBRIST)
@@ -182,6 +183,10 @@ void Search::Worker::start_searching() {
     if (!is_mainthread())
     {
         iterative_deepening();
+
+        // Publish the nodes of the last partial batch, so that the total is
+        // exact once all the threads have finished.
+        nodesShard->fetch_add(nodes & nodesBatchMask, std::memory_order_relaxed);
         return;
     }
 
@@ -404,6 +409,11 @@ void Search::Worker::start_searching() {
         }
         else
         {
+#if defined(SUG_FIXED_ZOBRIST)
+            if (expPrefill && Experience::enabled())
+                prefill_experience();
+#endif
+
             threads.start_searching();  // start non-main threads
             iterative_deepening();      // main thread start searching
         }
@@ -529,8 +539,10 @@ void Search::Worker::start_searching() {
             wrote_mpv = true;
         }
 
-        // Flush immediately if we wrote MultiPV entries (and not readonly)
-        if (wrote_mpv && !(bool)options["Experience Readonly"])
+        // Flush immediately if we wrote MultiPV entries (and not readonly). A
+        // paused store drops the entries and may be probed by other searches.
+        if (wrote_mpv && !Experience::is_learning_paused()
+            && !(bool)options["Experience Readonly"])
             Experience::save();
     }
 #endif
@@ -566,6 +578,58 @@ void Search::Worker::start_searching() {
     main_manager()->updates.onBestmove(bestmove, ponder);
 }
 
+#if defined(SUG_FIXED_ZOBRIST)
+// Walks the experience graph from the root along the stored moves and writes
+// the best entry of each position reached into the TT, as an exact bound at
+// the stored depth. The search then finds the experience in the TT and does
+// not need to probe the experience map at every node, where nearly all the
+// lookups miss.
+void Search::Worker::prefill_experience() {
+    constexpr size_t MaxPositions = 1 << 14;
+
+    std::vector<StateInfo> states(expPrefillPlies);
+    std::unordered_set<Key> visited;
+
+    auto usable = [](const Position& pos, const Experience::ExpEntryEx* exp) {
+        return exp->depth >= Experience::MinDepth && exp->move.is_ok()
+            && pos.pseudo_legal(exp->move) && pos.legal(exp->move);
+    };
+
+    auto walk = [&](auto&& self, Position& pos, int ply) -> void {
+        if (visited.size() >= MaxPositions || !visited.insert(pos.key()).second)
+            return;
+
+        const Experience::ExpEntryEx* first = Experience::probe(pos.key());
+        const Experience::ExpEntryEx* best  = nullptr;
+
+        for (auto* exp = first; exp; exp = exp->next)
+            if (usable(pos, exp) && (!best || exp->compare(best) > 0))
+                best = exp;
+
+        if (!best)
+            return;
+
+        // Experience values are stored relative to the position, as TT values
+        auto [ttHit, ttData, ttWriter] = tt.probe(pos.key());
+        ttWriter.write(pos.key(), best->value, true, BOUND_EXACT, best->depth, best->move,
+                       VALUE_NONE, tt.generation());
+
+        if (ply >= expPrefillPlies)
+            return;
+
+        for (auto* exp = first; exp; exp = exp->next)
+            if (usable(pos, exp))
+            {
+                pos.do_move(exp->move, states[ply]);
+                self(self, pos, ply + 1);
+                pos.undo_move(exp->move);
+            }
+    };
+
+    walk(walk, rootPos, 0);
+}
+#endif
+
 // Main iterative deepening loop. It calls search()
 // repeatedly with increasing depth until the allocated thinking time has been
 // consumed, the user stops the search, or the maximum search depth is reached.
@@ -622,6 +686,20 @@ void Search::Worker::iterative_deepening() {
 
     multiPV = std::min(multiPV, rootMoves.size());
 
+    // With Fast MultiPV every helper owns a line, cycling with its index, and
+    // the threads share their lines through ThreadPool::multiPVLines. Once the
+    // lines before its own are published, a helper excludes their moves and
+    // searches only its line, bounded by the score of the previous one. The
+    // main thread still searches and reports all the lines, centering the
+    // window of a line on the score of a helper that is ahead on it.
+    size_t ownedLine = 0;
+
+    if (fastMultiPV && !mainThread && multiPV > 1)
+    {
+        ownedLine = (threadIdx - 1) % multiPV;
+        multiPV   = ownedLine + 1;
+    }
+
     int searchAgainCounter = 0;
 
     lowPlyHistory.fill(97);
@@ -662,6 +740,28 @@ void Search::Worker::iterative_deepening() {
         size_t pvFirst = 0;
         pvLast         = 0;
 
+        // A helper moves the published moves of the lines before its own to the
+        // front, in line order, and skips their search. Until they are all
+        // published, or with root moves of different TB ranks, it searches the
+        // earlier lines itself.
+        size_t firstLine = 0;
+
+        if (ownedLine && rootMoves.front().tbRank == rootMoves.back().tbRank)
+        {
+            firstLine = ownedLine;
+
+            for (size_t i = 0; i < ownedLine && firstLine; ++i)
+            {
+                const auto it =
+                  std::find(rootMoves.begin() + i, rootMoves.end(), threads.multiPVLines.get(i).move);
+
+                if (it == rootMoves.end())
+                    firstLine = 0;
+                else
+                    std::rotate(rootMoves.begin() + i, it, it + 1);
+            }
+        }
+
         if (!threads.increaseDepth)
             searchAgainCounter++;
 
@@ -676,15 +776,48 @@ void Search::Worker::iterative_deepening() {
                         break;
             }
 
+            if (pvIdx < firstLine)
+                continue;
+
             // Reset UCI info selDepth for each depth and each PV line
             selDepth = 0;
 
+            // With Fast MultiPV, the main thread starts a line that a helper has
+            // already searched at this depth or deeper around the helper's score
+            Value sharedScore = VALUE_NONE;
+
+            if (fastMultiPV && mainThread && pvIdx > 0)
+            {
+                const auto line = threads.multiPVLines.get(pvIdx);
+
+                if (line.depth >= rootDepth
+                    && std::count(rootMoves.begin() + pvIdx, rootMoves.begin() + pvLast, line.move))
+                    sharedScore = line.score;
+            }
+
             // Reset aspiration window starting size
             delta     = 5 + threadIdx % 8 + std::abs(rootMoves[pvIdx].meanSquaredScore) / 9000;
-            Value avg = rootMoves[pvIdx].averageScore;
+            Value avg = sharedScore != VALUE_NONE ? sharedScore : rootMoves[pvIdx].averageScore;
             alpha     = std::max(avg - delta, -VALUE_INFINITE);
             beta      = std::min(avg + delta, VALUE_INFINITE);
 
+            // The moves of the earlier lines are excluded, so this line should not
+            // score above the previous one. With Fast MultiPV the window is capped
+            // there, which turns the search of a move that used to rank higher into
+            // little more than a null window verification of that bound. A helper
+            // that skipped the previous line takes the bound from the table.
+            if (fastMultiPV && pvIdx > pvFirst)
+            {
+                const Value bound = pvIdx == firstLine ? threads.multiPVLines.get(pvIdx - 1).score
+                                                       : rootMoves[pvIdx - 1].score;
+
+                if (!is_decisive(bound) && bound + 1 < beta)
+                {
+                    beta  = bound + 1;
+                    alpha = std::max(std::min(alpha, bound - delta), -VALUE_INFINITE);
+                }
+            }
+
             // Adjust optimism based on root move's averageScore
             optimism[us]  = 137 * avg / (std::abs(avg) + 91);
             optimism[~us] = -optimism[us];
@@ -764,6 +897,11 @@ void Search::Worker::iterative_deepening() {
                 assert(alpha >= -VALUE_INFINITE && beta <= VALUE_INFINITE);
             }
 
+            // Share the line before it is sorted with the earlier ones
+            if (fastMultiPV && multiPV > 1 && !threads.stop && (mainThread || pvIdx == ownedLine))
+                threads.multiPVLines.publish(pvIdx, rootMoves[pvIdx].pv[0], rootMoves[pvIdx].score,
+                                             rootDepth);
+
             // Sort the PV lines searched so far and update the GUI
             std::stable_sort(rootMoves.begin() + pvFirst, rootMoves.begin() + pvIdx + 1);
 
@@ -784,6 +922,10 @@ void Search::Worker::iterative_deepening() {
         if (!threads.stop)
             completedDepth = rootDepth;
 
+        // From now on the helpers may stop the search on the nodes limit
+        if (is_mainthread() && completedDepth >= 1)
+            threads.nodesLimitArmed = true;
+
         // We make sure not to pick an unproven mated-in score,
         // in case this thread prematurely stopped search (aborted-search).
         if (threads.abortedSearch && rootMoves[0].score != -VALUE_INFINITE
@@ -816,8 +958,14 @@ void Search::Worker::iterative_deepening() {
 
         // If the skill level is enabled and time is up, pick a sub-optimal best move
         if (skill.enabled() && skill.time_to_pick(rootDepth))
+        {
             skill.pick_best(rootMoves, multiPV);
 
+            // The picked move is final, deeper iterations would be thrown away
+            if (skillBudget)
+                break;
+        }
+
         // Use part of the gained time from a previous stable move for the current move
         for (auto&& th : threads)
         {
@@ -897,8 +1045,22 @@ void Search::Worker::do_move(
   Position& pos, const Move move, StateInfo& st, const bool givesCheck, Stack* const ss) {
     bool       capture = pos.capture_stage(move);
     DirtyPiece dp      = pos.do_move(move, st, givesCheck, &tt);
-    nodes.fetch_add(1, std::memory_order_relaxed);
+    uint64_t   n       = nodes.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (nodesShard && !(n & nodesBatchMask))
+    {
+        nodesShard->fetch_add(nodesBatchMask + 1, std::memory_order_relaxed);
+
+        // Helpers also test the nodes limit on each batch, so that the search
+        // stops close to it even when the main thread checks late.
+        if (limits.nodes && threads.nodesLimitArmed
+            && threads.nodes_searched() >= limits.nodes && !threads.main_manager()->ponder)
+            threads.stop = threads.abortedSearch = true;
+    }
     accumulatorStack.push(dp);
+
+    if (nnuePrefetch)
+        Eval::prefetch_weights(networks[numaAccessToken], pos, dp, smallNetOnly);
+
     if (ss != nullptr)
     {
         ss->currentMove         = move;
@@ -942,6 +1104,11 @@ void Search::Worker::clear() {
         reductions[i] = int(2809 / 128.0 * std::log(i));
 
     refreshTable.clear(networks[numaAccessToken]);
+
+    evalCache.resize(size_t(options["NNUE Eval Cache"]));
+    evalCache.clear();
+
+    tbCacheStats = {};
 }
 
 
@@ -1054,9 +1221,10 @@ Value Search::Worker::search(
     ttCapture    = ttData.move && pos.capture_stage(ttData.move);
 
 #if defined(SUG_FIXED_ZOBRIST)
-    // Probe experience data
-    const Experience::ExpEntryEx* expEx =
-        (!excludedMove && Experience::enabled()) ? Experience::probe(pos.key()) : nullptr;
+    // Probe experience data, unless it has been written into the TT at the root
+    const bool expProbe = !excludedMove && !expPrefill && Experience::enabled();
+
+    const Experience::ExpEntryEx* expEx = expProbe ? Experience::probe(pos.key()) : nullptr;
     const Experience::ExpEntryEx* tempExp = expEx;
     const Experience::ExpEntryEx* bestExp = nullptr;
 
@@ -1139,7 +1307,7 @@ if constexpr (!PvNode)
         tbHits.fetch_add(expCount, std::memory_order_relaxed);
 
     // Step 3bis. Experience lookup con priorità se più profondo del TT
-    if (!excludedMove && Experience::enabled())
+    if (expProbe)
     {
         const auto* bestExpEntry = Experience::find_best_entry(pos.key());
         if (bestExpEntry && (!ss->ttHit || bestExpEntry->depth > ttData.depth))
@@ -1242,7 +1410,7 @@ if constexpr (!PvNode)
             && pos.rule50_count() == 0 && !pos.can_castle(ANY_CASTLING))
         {
             TB::ProbeState err;
-            TB::WDLScore   wdl = Tablebases::probe_wdl(pos, &err);
+            TB::WDLScore   wdl = Tablebases::probe_wdl(pos, &err, &tbCacheStats);
 
             // Force check of time on the next occasion
             if (is_mainthread())
@@ -2292,7 +2460,7 @@ TimePoint Search::Worker::elapsed_time() const { return main_manager()->tm.elaps
 
 Value Search::Worker::evaluate(const Position& pos) {
     return Eval::evaluate(networks[numaAccessToken], pos, accumulatorStack, refreshTable,
-                          optimism[pos.side_to_move()]);
+                          optimism[pos.side_to_move()], &evalCache, smallNetOnly);
 }
 
 namespace {
@@ -206,6 +206,14 @@ struct Skill {
     bool time_to_pick(Depth depth) const { return depth == 1 + int(level); }
     Move pick_best(const RootMoves&, size_t multiPV);
 
+    // With "Skill Budget" and a Skill Level, the search ends at the depth the
+    // move is picked at and is capped by a node budget several times what that
+    // depth usually takes. The lower levels, whose picks are dominated by the
+    // random term, also evaluate with the small net only. None of this is
+    // calibrated against the Elo scale above, so UCI_Elo never uses it.
+    std::uint64_t node_budget() const { return std::uint64_t(8192) << int(level * 3 / 4); }
+    bool          small_net_only() const { return level < 10.0; }
+
     double level;
     Move   best = Move::none();
 };
@@ -296,6 +304,9 @@ class Worker {
    private:
     void iterative_deepening();
 
+    // Writes the experience reachable from the root into the TT
+    void prefill_experience();
+
     void do_move(Position& pos, const Move move, StateInfo& st, Stack* const ss);
     void
     do_move(Position& pos, const Move move, StateInfo& st, const bool givesCheck, Stack* const ss);
@@ -330,6 +341,27 @@ class Worker {
     std::atomic<uint64_t> nodes, tbHits, bestMoveChanges;
     int                   selDepth, nmpMinPly;
 
+    // Shard of the thread pool node counter the nodes are published to in
+    // batches of nodesBatchMask + 1, nullptr for the main thread.
+    std::atomic<uint64_t>* nodesShard     = nullptr;
+    uint64_t               nodesBatchMask = 0;
+
+    // Prefetch the NNUE weights the next evaluation needs when making a move
+    bool nnuePrefetch = false;
+
+    // Cheap strength limited search, see Skill::node_budget()
+    bool skillBudget  = false;
+    bool smallNetOnly = false;
+
+    // Give every helper a MultiPV line of its own and bound each line by the
+    // score of the previous one, see iterative_deepening()
+    bool fastMultiPV = false;
+
+    // Fill the TT with experience data at the root instead of probing it at
+    // every node, following stored moves up to expPrefillPlies from the root
+    bool expPrefill      = false;
+    int  expPrefillPlies = 0;
+
     Value optimism[COLOR_NB];
 
     Position  rootPos;
@@ -367,6 +399,8 @@ class Worker {
     // Used by NNUE
     Eval::NNUE::AccumulatorStack  accumulatorStack;
     Eval::NNUE::AccumulatorCaches refreshTable;
+    Eval::NNUE::EvalCache         evalCache;
+    Tablebases::ProbeCacheStats   tbCacheStats{};
 
     friend class Sugar::ThreadPool;
     friend class SearchManager;
@@ -0,0 +1,195 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "selfplay.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "misc.h"
+#include "movegen.h"
+#include "position.h"
+#include "thread.h"
+#include "tt.h"
+#include "uci.h"
+#include "ucioption.h"
+
+namespace Sugar::SelfPlay {
+
+namespace {
+
+constexpr std::string_view StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// One side of a game: a single threaded pool with its own TT and histories,
+// kept for the whole game as a separate engine process would.
+// The pool is declared last so that its threads are gone before the rest.
+struct Player {
+    Search::SearchManager::UpdateContext updateContext;
+    std::string                          bestmove;
+    TranspositionTable                   tt;
+    ThreadPool                           pool;
+};
+
+// A game in progress. players[0] uses parameter set A, players[1] set B.
+struct Slot {
+    Player       players[2];
+    Position     pos;
+    StateListPtr states;
+    bool         active = false;
+    bool         aIsWhite;
+
+    int to_move() const { return (pos.side_to_move() == WHITE) == aIsWhite ? 0 : 1; }
+};
+
+}  // namespace
+
+Result run(const Config&                                   config,
+           const OptionsMap&                               options,
+           const NumaConfig&                               numaConfig,
+           const LazyNumaReplicated<Eval::NNUE::Networks>& networks,
+           const ApplyParams&                              applyParams) {
+
+    const bool chess960 = options["UCI_Chess960"];
+    const int  slotCount =
+      int(std::min(std::max(config.concurrency, std::size_t(1)), std::size_t(config.games)));
+
+    Result result;
+    int    started = 0;
+
+    std::vector<std::unique_ptr<Slot>> slots;
+
+    for (int i = 0; i < slotCount; ++i)
+    {
+        auto& slot = *slots.emplace_back(std::make_unique<Slot>());
+
+        for (auto& player : slot.players)
+        {
+            player.updateContext = {[](const auto&) {}, [](const auto&) {}, [](const auto&) {},
+                                    [&player](std::string_view best, std::string_view) {
+                                        player.bestmove = std::string(best);
+                                    }};
+
+            player.pool.set(numaConfig,
+                            Search::SharedState(options, player.pool, player.tt, networks),
+                            player.updateContext, 1);
+            player.tt.resize(config.hashMB, player.pool);
+        }
+    }
+
+    // Every opening is played twice, with A as white and then as black
+    auto start_game = [&](Slot& slot) {
+        slot.active = started < config.games;
+
+        if (!slot.active)
+            return;
+
+        const std::string fen =
+          config.openings.empty() ? std::string(StartFEN)
+                                  : config.openings[(started / 2) % config.openings.size()];
+
+        for (auto& player : slot.players)
+        {
+            player.pool.clear();
+            player.tt.clear(player.pool);
+        }
+
+        slot.states   = StateListPtr(new std::deque<StateInfo>(1));
+        slot.aIsWhite = started % 2 == 0;
+        slot.pos.set(fen, chess960, &slot.states->back());
+        ++started;
+    };
+
+    // Returns the score of the finished game for A, or -1 if it goes on
+    auto game_over = [&](const Slot& slot) {
+        if (MoveList<LEGAL>(slot.pos).size() == 0)
+            return slot.pos.checkers() ? (slot.to_move() == 0 ? 0 : 2) : 1;
+
+        if (slot.pos.is_draw(0) || int(slot.states->size()) > config.maxPlies)
+            return 1;
+
+        return -1;
+    };
+
+    for (auto& slot : slots)
+        start_game(*slot);
+
+    while (true)
+    {
+        bool anyActive = false;
+
+        for (int player : {0, 1})
+        {
+            std::vector<Slot*> moving;
+
+            for (auto& slot : slots)
+                if (slot->active && slot->to_move() == player)
+                    moving.push_back(slot.get());
+
+            anyActive |= !moving.empty();
+
+            if (moving.empty())
+                continue;
+
+            applyParams(player);
+
+            for (Slot* slot : moving)
+            {
+                Search::LimitsType limits = config.limits;
+                limits.startTime          = now();
+
+                slot->players[player].bestmove.clear();
+                slot->players[player].pool.start_thinking(options, slot->pos, slot->states,
+                                                          limits);
+            }
+
+            for (Slot* slot : moving)
+            {
+                slot->players[player].pool.main_thread()->wait_for_search_finished();
+
+                const Move m = UCIEngine::to_move(slot->pos, slot->players[player].bestmove);
+                int        score;
+
+                if (m == Move::none())
+                    score = 1;
+                else
+                {
+                    slot->states->emplace_back();
+                    slot->pos.do_move(m, slot->states->back());
+                    score = game_over(*slot);
+                }
+
+                if (score < 0)
+                    continue;
+
+                (score == 2 ? result.wins : score == 1 ? result.draws : result.losses)++;
+                start_game(*slot);
+            }
+        }
+
+        if (!anyActive)
+            break;
+    }
+
+    return result;
+}
+
+}  // namespace Sugar::SelfPlay
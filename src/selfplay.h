@@ -0,0 +1,76 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SELFPLAY_H_INCLUDED
+#define SELFPLAY_H_INCLUDED
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "numa.h"
+#include "search.h"
+
+namespace Sugar {
+
+class OptionsMap;
+
+namespace Eval::NNUE {
+struct Networks;
+}
+
+namespace SelfPlay {
+
+// A match between two parameter sets A and B, played inside the engine so
+// that SPSA iterations do not pay for process startup and network loading.
+struct Config {
+    int                      games       = 2;
+    std::size_t              concurrency = 1;
+    int                      maxPlies    = 400;  // longer games are adjudicated as draws
+    std::size_t              hashMB      = 16;   // per player
+    std::vector<std::string> openings;           // FENs, each played with both colours
+    Search::LimitsType       limits;             // only nodes and movetime are used
+};
+
+// Option values, as name and value pairs, that make up a parameter set
+using Params = std::vector<std::pair<std::string, std::string>>;
+
+// Game results from the point of view of parameter set A
+struct Result {
+    int wins = 0, draws = 0, losses = 0;
+};
+
+// Called with 0 or 1 before the moves of player A or B are searched. The
+// tuned parameters are globals shared by all the searches, so the players
+// never search at the same time: all the games wait for A to move, then
+// all the games wait for B.
+using ApplyParams = std::function<void(int player)>;
+
+Result run(const Config&                                   config,
+           const OptionsMap&                               options,
+           const NumaConfig&                               numaConfig,
+           const LazyNumaReplicated<Eval::NNUE::Networks>& networks,
+           const ApplyParams&                              applyParams);
+
+}  // namespace SelfPlay
+
+}  // namespace Sugar
+
+#endif  // #ifndef SELFPLAY_H_INCLUDED
@@ -0,0 +1,306 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server.h"
+
+#include <algorithm>
+#include <deque>
+#include <utility>
+
+#include "misc.h"
+#include "uci.h"
+
+#ifdef SUG_FIXED_ZOBRIST
+    #include "experience.h"
+#endif
+
+namespace Sugar {
+
+namespace {
+
+constexpr auto StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+}  // namespace
+
+// The options are a copy without the callbacks of the engine options, those
+// that act on the session are applied by SessionServer::setoption(). The pool
+// is declared last so that its threads are gone before the rest.
+struct SessionServer::Session {
+    std::string        id;
+    OptionsMap         options;
+    UpdateContext      updateContext;
+    Position           pos;
+    StateListPtr       states;
+    TranspositionTable tt;
+    ThreadPool         pool;
+
+    // ThreadPool::wait_for_search_finished() only waits for the helpers
+    void wait_for_search_finished() {
+        if (pool.size())
+            pool.main_thread()->wait_for_search_finished();
+    }
+};
+
+SessionServer::SessionServer(const OptionsMap&                               engineOptions,
+                             const ThreadPool&                               mainThreads,
+                             const NumaReplicationContext&                   context,
+                             const LazyNumaReplicated<Eval::NNUE::Networks>& sharedNetworks) :
+    defaults(engineOptions),
+    engineThreads(mainThreads),
+    numaContext(context),
+    networks(sharedNetworks) {}
+
+SessionServer::~SessionServer() { close_all(); }
+
+void SessionServer::set_listener_factory(ListenerFactory&& f) { listenerFactory = std::move(f); }
+
+SessionServer::Session* SessionServer::find(const std::string& id) const {
+    auto it = sessions.find(id);
+    return it != sessions.end() ? it->second.get() : nullptr;
+}
+
+bool SessionServer::open(const std::string& id) {
+    if (find(id))
+        return true;
+
+    if (thread_count() >= thread_budget())
+    {
+        sync_cout << "info string no thread left for session " << id << ", "
+                  << thread_count() << " of " << thread_budget() << " used" << sync_endl;
+        return false;
+    }
+
+    auto& s = *sessions.emplace(id, std::make_unique<Session>()).first->second;
+
+    s.id = id;
+
+    for (const auto& [name, option] : defaults.options_map)
+    {
+        auto& copy     = s.options.options_map.emplace(name, option).first->second;
+        copy.on_change = nullptr;
+        copy.parent    = &s.options;
+    }
+
+    // A new session starts small, so that it does not take the threads and
+    // the memory of the next ones. The engine values are often sized for a
+    // single game that has the whole machine.
+    for (const char* name : {"Threads", "Hash"})
+    {
+        auto& option = s.options.options_map.find(name)->second;
+        option       = option.defaultValue;
+    }
+
+    if (listenerFactory)
+        s.updateContext = listenerFactory(id);
+
+    s.states = StateListPtr(new std::deque<StateInfo>(1));
+    s.pos.set(StartFEN, s.options["UCI_Chess960"], &s.states->back());
+
+    resize_threads(s);
+
+#ifdef SUG_FIXED_ZOBRIST
+    // The Experience store is shared by all the games but its tables are not
+    // safe for writes concurrent with probes, so it is only read while there
+    // are sessions.
+    if (sessions.size() == 1)
+        Experience::pause_learning();
+#endif
+
+    return true;
+}
+
+bool SessionServer::close(const std::string& id) {
+    auto it = sessions.find(id);
+    if (it == sessions.end())
+        return false;
+
+    it->second->pool.stop = true;
+    it->second->wait_for_search_finished();
+    sessions.erase(it);
+
+#ifdef SUG_FIXED_ZOBRIST
+    if (sessions.empty())
+        Experience::resume_learning();
+#endif
+
+    return true;
+}
+
+void SessionServer::close_all() {
+    while (!sessions.empty())
+        close(sessions.begin()->first);
+}
+
+void SessionServer::resize_threads(Session& s) {
+    s.wait_for_search_finished();
+
+    // The threads of the main search and of the other sessions
+    const size_t others = thread_count() - s.pool.size();
+    const size_t budget = thread_budget();
+    const size_t wanted = size_t(s.options["Threads"]);
+    const size_t count  = std::max(std::min(wanted, budget > others ? budget - others : 0),
+                                   size_t(1));
+
+    if (count < wanted)
+        sync_cout << "info string session " << s.id << " limited to " << count << " thread"
+                  << (count > 1 ? "s" : "") << sync_endl;
+
+    // As in Engine::resize_threads(), a kept pool keeps the hash contents too
+    if (s.pool.set(numaContext.get_numa_config(), {s.options, s.pool, s.tt, networks},
+                   s.updateContext, count))
+        s.tt.resize(size_t(s.options["Hash"]), s.pool);
+
+    s.pool.ensure_network_replicated();
+}
+
+bool SessionServer::set_position(const std::string&              id,
+                                 const std::string&              fen,
+                                 const std::vector<std::string>& moves) {
+    Session* s = find(id);
+    if (!s)
+        return false;
+
+    s->wait_for_search_finished();
+
+    s->states = StateListPtr(new std::deque<StateInfo>(1));
+    s->pos.set(fen, s->options["UCI_Chess960"], &s->states->back());
+
+    for (const auto& move : moves)
+    {
+        auto m = UCIEngine::to_move(s->pos, move);
+
+        if (m == Move::none())
+            break;
+
+        s->states->emplace_back();
+        s->pos.do_move(m, s->states->back());
+    }
+
+    return true;
+}
+
+bool SessionServer::go(const std::string& id, Search::LimitsType& limits) {
+    Session* s = find(id);
+    if (!s)
+        return false;
+
+    s->wait_for_search_finished();
+    s->pool.start_thinking(s->options, s->pos, s->states, limits);
+    return true;
+}
+
+bool SessionServer::stop(const std::string& id) {
+    Session* s = find(id);
+    if (s)
+        s->pool.stop = true;
+    return s;
+}
+
+void SessionServer::stop_all() {
+    for (auto& [id, s] : sessions)
+        s->pool.stop = true;
+}
+
+void SessionServer::wait_for_search_finished() {
+    for (auto& [id, s] : sessions)
+        s->wait_for_search_finished();
+}
+
+bool SessionServer::set_ponderhit(const std::string& id) {
+    Session* s = find(id);
+    if (s)
+        s->pool.main_manager()->ponder = false;
+    return s;
+}
+
+bool SessionServer::search_clear(const std::string& id) {
+    Session* s = find(id);
+    if (!s)
+        return false;
+
+    s->wait_for_search_finished();
+    s->tt.clear(s->pool);
+    s->pool.clear();
+    return true;
+}
+
+bool SessionServer::wait_for_search_finished(const std::string& id) {
+    Session* s = find(id);
+    if (s)
+        s->wait_for_search_finished();
+    return s;
+}
+
+// Options that the engine applies to global state, like the networks or the
+// Experience file, keep their engine wide values: a session only stores them.
+bool SessionServer::setoption(const std::string& id, std::istringstream& is) {
+    Session* s = find(id);
+    if (!s)
+        return false;
+
+    std::string token, name, value;
+
+    is >> token;  // Consume the "name" token
+
+    while (is >> token && token != "value")
+        name += (name.empty() ? "" : " ") + token;
+
+    while (is >> token)
+        value += (value.empty() ? "" : " ") + token;
+
+    auto it = s->options.options_map.find(name);
+    if (it == s->options.options_map.end())
+    {
+        sync_cout << "No such option: " << name << sync_endl;
+        return true;
+    }
+
+    s->wait_for_search_finished();
+    it->second = value;
+
+    // Compare by the stored name, the lookup is case insensitive
+    if (it->first == "Threads" || it->first == "NumaPolicy" || it->first == "Thread Placement")
+        resize_threads(*s);
+    else if (it->first == "Hash")
+        s->tt.resize(size_t(s->options["Hash"]), s->pool);
+    else if (it->first == "Clear Hash")
+        search_clear(id);
+
+    return true;
+}
+
+size_t SessionServer::thread_budget() const { return size_t(defaults["Server Threads"]); }
+
+size_t SessionServer::thread_count() const {
+    size_t count = engineThreads.size();
+    for (const auto& [id, s] : sessions)
+        count += s->pool.size();
+    return count;
+}
+
+std::vector<std::string> SessionServer::information() const {
+    std::vector<std::string> lines;
+
+    for (const auto& [id, s] : sessions)
+        lines.push_back("session " + id + " threads " + std::to_string(s->pool.size()) + " hash "
+                        + std::to_string(int(s->options["Hash"])));
+
+    return lines;
+}
+
+}  // namespace Sugar
@@ -0,0 +1,118 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SERVER_H_INCLUDED
+#define SERVER_H_INCLUDED
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "numa.h"
+#include "position.h"
+#include "search.h"
+#include "thread.h"
+#include "tt.h"
+#include "ucioption.h"
+
+namespace Sugar {
+
+namespace Eval::NNUE {
+struct Networks;
+}
+
+// Hosts many independent games in one process, e.g. for a bot or analysis
+// server, so that the networks are loaded and the Experience file is read
+// only once. Every session has its own position, options, TT and threads,
+// as a separate engine process would, and shares the rest with the engine.
+class SessionServer {
+   public:
+    using UpdateContext = Search::SearchManager::UpdateContext;
+
+    // Creates the search listeners of a new session, given its id
+    using ListenerFactory = std::function<UpdateContext(const std::string&)>;
+
+    SessionServer(const OptionsMap&                               defaults,
+                  const ThreadPool&                               engineThreads,
+                  const NumaReplicationContext&                   numaContext,
+                  const LazyNumaReplicated<Eval::NNUE::Networks>& networks);
+
+    ~SessionServer();
+
+    SessionServer(const SessionServer&)            = delete;
+    SessionServer& operator=(const SessionServer&) = delete;
+
+    void set_listener_factory(ListenerFactory&&);
+
+    // A session is opened by the first command that names it. It starts with
+    // a copy of the current engine options, but the default Threads and Hash,
+    // and the start position. Returns false if it could not be opened, when
+    // there is no thread left for it.
+    bool open(const std::string& id);
+    bool close(const std::string& id);
+    void close_all();
+
+    // Each returns false if there is no such session
+    bool set_position(const std::string&              id,
+                      const std::string&              fen,
+                      const std::vector<std::string>& moves);
+    bool go(const std::string& id, Search::LimitsType& limits);
+    bool stop(const std::string& id);
+    bool set_ponderhit(const std::string& id);
+    bool search_clear(const std::string& id);
+    bool wait_for_search_finished(const std::string& id);
+    bool setoption(const std::string& id, std::istringstream& is);
+
+    void stop_all();
+    void wait_for_search_finished();
+
+    std::size_t size() const { return sessions.size(); }
+
+    // Threads of the main search and all the sessions, which together stay
+    // within the "Server Threads" value of the engine
+    std::size_t thread_count() const;
+    std::size_t thread_budget() const;
+
+    // One line per session with its id, threads and hash size
+    std::vector<std::string> information() const;
+
+   private:
+    struct Session;
+
+    Session* find(const std::string& id) const;
+
+    // Sizes the pool of the session to its "Threads" option, as far as the
+    // threads of the other sessions leave room for it
+    void resize_threads(Session& s);
+
+    const OptionsMap&                               defaults;
+    const ThreadPool&                               engineThreads;
+    const NumaReplicationContext&                   numaContext;
+    const LazyNumaReplicated<Eval::NNUE::Networks>& networks;
+
+    ListenerFactory                                 listenerFactory;
+    std::map<std::string, std::unique_ptr<Session>> sessions;
+};
+
+}  // namespace Sugar
+
+#endif  // #ifndef SERVER_H_INCLUDED
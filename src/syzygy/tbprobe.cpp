@@ -28,10 +28,13 @@
 #include <fstream>
 #include <initializer_list>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string_view>
 #include <sys/stat.h>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -353,9 +356,12 @@ struct TBTable {
     static constexpr int Sides = Type == WDL ? 2 : 1;
 
     std::atomic_bool ready;
+    std::atomic_bool warmed;
+    std::mutex       mutex;  // Taken to publish the mapping, see mapped()
     void*            baseAddress;
     uint8_t*         map;
     uint64_t         mapping;
+    std::string      name;  // File name without extension, like "KRvK"
     Key              key;
     Key              key2;
     int              pieceCount;
@@ -368,6 +374,7 @@ struct TBTable {
 
     TBTable() :
         ready(false),
+        warmed(false),
         baseAddress(nullptr) {}
     explicit TBTable(const std::string& code);
     explicit TBTable(const TBTable<WDL>& wdl);
@@ -385,6 +392,7 @@ TBTable<WDL>::TBTable(const std::string& code) :
     StateInfo st;
     Position  pos;
 
+    name       = code;
     key        = pos.set(code, WHITE, &st).material_key();
     pieceCount = pos.count<ALL_PIECES>();
     hasPawns   = pos.pieces(PAWN);
@@ -411,6 +419,7 @@ TBTable<DTZ>::TBTable(const TBTable<WDL>& wdl) :
     TBTable() {
 
     // Use the corresponding WDL table to avoid recalculating all from scratch
+    name            = wdl.name;
     key             = wdl.key;
     key2            = wdl.key2;
     pieceCount      = wdl.pieceCount;
@@ -498,6 +507,14 @@ class TBTables {
     }
 
     void add(const std::vector<PieceType>& pieces);
+
+    template<TBType Type>
+    std::deque<TBTable<Type>>& tables() {
+        if constexpr (Type == WDL)
+            return wdlTable;
+        else
+            return dtzTable;
+    }
 };
 
 TBTables TBTables;
@@ -1206,37 +1223,38 @@ void set(T& e, uint8_t* data) {
         }
 }
 
-// If the TB file corresponding to the given position is already memory-mapped
-// then return its base address, otherwise, try to memory map and init it. Called
-// at every probe, memory map, and init only at first access. Function is thread
-// safe and can be called concurrently.
+// If the TB file of the given table is already memory-mapped then return its
+// base address, otherwise, try to memory map and init it. Called at every probe
+// and by the prewarming thread, memory map, and init only at first access.
+// Function is thread safe and can be called concurrently. The file is mapped
+// outside of any lock and the table is initialized under its own lock, so a
+// thread mapping one table never waits for another table. Two threads that
+// race for the same table may both map it, the one that loses unmaps its copy.
 template<TBType Type>
-void* mapped(TBTable<Type>& e, const Position& pos) {
-
-    static std::mutex mutex;
+void* mapped(TBTable<Type>& e) {
 
     // Use 'acquire' to avoid a thread reading 'ready' == true while
     // another is still working. (compiler reordering may cause this).
     if (e.ready.load(std::memory_order_acquire))
         return e.baseAddress;  // Could be nullptr if file does not exist
 
-    std::scoped_lock<std::mutex> lk(mutex);
+    std::string fname = e.name + (Type == WDL ? ".rtbw" : ".rtbz");
 
-    if (e.ready.load(std::memory_order_relaxed))  // Recheck under lock
-        return e.baseAddress;
+    void*    baseAddress = nullptr;
+    uint64_t mapping     = 0;
+    uint8_t* data        = TBFile(fname).map(&baseAddress, &mapping, Type);
+
+    std::scoped_lock<std::mutex> lk(e.mutex);
 
-    // Pieces strings in decreasing order for each color, like ("KPP","KR")
-    std::string fname, w, b;
-    for (PieceType pt = KING; pt >= PAWN; --pt)
+    if (e.ready.load(std::memory_order_relaxed))  // Recheck under lock
     {
-        w += std::string(popcount(pos.pieces(WHITE, pt)), PieceToChar[pt]);
-        b += std::string(popcount(pos.pieces(BLACK, pt)), PieceToChar[pt]);
+        if (baseAddress)
+            TBFile::unmap(baseAddress, mapping);
+        return e.baseAddress;
     }
 
-    fname =
-      (e.key == pos.material_key() ? w + 'v' + b : b + 'v' + w) + (Type == WDL ? ".rtbw" : ".rtbz");
-
-    uint8_t* data = TBFile(fname).map(&e.baseAddress, &e.mapping, Type);
+    e.baseAddress = baseAddress;
+    e.mapping     = mapping;
 
     if (data)
         set(e, data);
@@ -1253,7 +1271,7 @@ Ret probe_table(const Position& pos, ProbeState* result, WDLScore wdl = WDLDraw)
 
     TBTable<Type>* entry = TBTables.get<Type>(pos.material_key());
 
-    if (!entry || !mapped(*entry, pos))
+    if (!entry || !mapped(*entry))
         return *result = FAIL, Ret();
 
     return do_probe_table(pos, entry, wdl, result);
@@ -1332,6 +1350,200 @@ WDLScore search(Position& pos, ProbeState* result) {
     return *result = OK, value;
 }
 
+// ProbeCache keeps the outcome of recent successful WDL and DTZ probes so that
+// a position probed again, by the same or by another thread, does not have to
+// decompress a block of the table file again. Each entry is a single 64-bit
+// word, read and written with relaxed atomics, so the cache is lock-free and
+// an entry is either seen whole or not at all. The upper bits of the key are
+// stored for verification, the lower ones select the slot, and a colliding
+// probe simply overwrites the slot. The lookups and hits are counted by the
+// caller, per search thread, so that the probes share no counter.
+class ProbeCache {
+
+    // Entry layout: bits 0-2 probe state + 2 (0 means empty), bits 3-15 the
+    // probed value + 4096, bits 20-63 the verification key.
+    static constexpr uint64_t KeyMask     = ~uint64_t(0xFFFFF);
+    static constexpr int      ValueOffset = 4096;
+
+   public:
+    // DTZ entries are stored under a different key than WDL entries of the
+    // same position.
+    static constexpr Key DTZSalt = 0x9E3779B97F4A7C15ULL;
+
+    void resize(size_t mbSize) {
+
+        size_t count = mbSize * 1024 * 1024 / sizeof(std::atomic<uint64_t>);
+
+        // Round down to a power of two to index the table with a mask
+        while (count & (count - 1))
+            count &= count - 1;
+
+        table = count ? std::make_unique<std::atomic<uint64_t>[]>(count) : nullptr;
+        mask  = count ? count - 1 : 0;
+
+        clear();
+    }
+
+    void clear() {
+
+        for (size_t i = 0; table && i <= mask; ++i)
+            table[i].store(0, std::memory_order_relaxed);
+    }
+
+    bool enabled() const { return bool(table); }
+
+    bool probe(Key key, int& value, ProbeState& state, ProbeCacheStats* stats) {
+
+        if (stats)
+            stats->lookups++;
+
+        const uint64_t e = table[key & mask].load(std::memory_order_relaxed);
+
+        if (!(e & 7) || (e & KeyMask) != (key & KeyMask))
+            return false;
+
+        if (stats)
+            stats->hits++;
+
+        state = ProbeState(int(e & 7) - 2);
+        value = int((e >> 3) & 0x1FFF) - ValueOffset;
+        return true;
+    }
+
+    void save(Key key, int value, ProbeState state) {
+
+        assert(state != FAIL && std::abs(value) < ValueOffset);
+
+        const uint64_t e = (key & KeyMask) | (uint64_t(value + ValueOffset) << 3)
+                         | uint64_t(int(state) + 2);
+
+        table[key & mask].store(e, std::memory_order_relaxed);
+    }
+
+   private:
+    std::unique_ptr<std::atomic<uint64_t>[]> table;
+    size_t                                   mask = 0;
+};
+
+ProbeCache TBProbeCache;
+
+// Prewarmer maps the tables on a background thread, fewest pieces first and
+// WDL before DTZ, and asks the kernel to read them ahead so that the first
+// probes of a session do not stall on page faults. The search only waits for
+// it when it probes the very table being initialized, which it would otherwise
+// have to initialize itself: the tables are mapped without a common lock.
+class Prewarmer {
+
+    // Read ahead in chunks so that a stop request is honoured quickly
+    static constexpr size_t ChunkSize = 16 * 1024 * 1024;
+
+   public:
+    bool enabled = false;
+
+    ~Prewarmer() { stop(); }
+
+    void start() {
+
+        stop();
+        quit = false;
+        th   = std::thread(&Prewarmer::run, this);
+    }
+
+    void stop() {
+
+        quit = true;
+        if (th.joinable())
+            th.join();
+    }
+
+   private:
+    void run();
+
+    template<TBType Type>
+    size_t warm(TBTable<Type>& e);
+
+    std::thread      th;
+    std::atomic_bool quit{false};
+};
+
+// Maps a table and reads it ahead, returns the size of the file
+template<TBType Type>
+size_t Prewarmer::warm(TBTable<Type>& e) {
+
+    if (e.warmed.load(std::memory_order_relaxed) || !mapped(e))
+        return 0;
+
+#ifndef _WIN32
+    #if defined(MADV_WILLNEED)
+    for (size_t offset = 0; offset < e.mapping && !quit; offset += ChunkSize)
+        madvise((char*) e.baseAddress + offset, std::min(ChunkSize, size_t(e.mapping - offset)),
+                MADV_WILLNEED);
+    #endif
+
+    e.warmed = !quit;
+    return e.mapping;
+#else
+    // On Windows the file is only mapped, its pages are read at first access
+    e.warmed = true;
+    return 0;
+#endif
+}
+
+void Prewarmer::run() {
+
+    std::vector<TBTable<WDL>*> wdl;
+    std::vector<TBTable<DTZ>*> dtz;
+
+    for (auto& e : TBTables.tables<WDL>())
+        wdl.push_back(&e);
+    for (auto& e : TBTables.tables<DTZ>())
+        dtz.push_back(&e);
+
+    auto byPieces = [](const auto* a, const auto* b) { return a->pieceCount < b->pieceCount; };
+    std::stable_sort(wdl.begin(), wdl.end(), byPieces);
+    std::stable_sort(dtz.begin(), dtz.end(), byPieces);
+
+    // Reading ahead more than the page cache can hold would only evict the
+    // tables warmed first, so stop at half of the physical memory.
+    size_t budget = std::numeric_limits<size_t>::max();
+#if !defined(_WIN32) && defined(_SC_PHYS_PAGES)
+    budget = size_t(sysconf(_SC_PHYS_PAGES)) / 2 * size_t(sysconf(_SC_PAGESIZE));
+#endif
+
+    const size_t total = wdl.size() + dtz.size();
+    size_t       done = 0, bytes = 0, reported = 0;
+    TimePoint    start = now();
+
+    auto report = [&]() {
+        sync_cout << "info string Syzygy prewarm " << done << "/" << total << " files, "
+                  << (bytes >> 20) << " MB in " << now() - start << " ms" << sync_endl;
+    };
+
+    auto step = [&](size_t size) {
+        bytes += size;
+
+        // Report every 25% of the files
+        if (4 * ++done / total > reported)
+        {
+            reported = 4 * done / total;
+            report();
+        }
+    };
+
+    for (auto* e : wdl)
+        if (!quit && bytes < budget)
+            step(warm(*e));
+
+    for (auto* e : dtz)
+        if (!quit && bytes < budget)
+            step(warm(*e));
+
+    if (!quit && done < total)  // Stopped at the memory budget
+        report();
+}
+
+Prewarmer TBPrewarmer;
+
 }  // namespace
 
 
@@ -1340,7 +1552,9 @@ WDLScore search(Position& pos, ProbeState* result) {
 // safe, nor it needs to be.
 void Tablebases::init(const std::string& paths) {
 
+    TBPrewarmer.stop();
     TBTables.clear();
+    TBProbeCache.clear();
     MaxCardinality = 0;
     TBFile::Paths  = paths;
 
@@ -1485,8 +1699,28 @@ void Tablebases::init(const std::string& paths) {
     }
 
     TBTables.info();
+
+    if (TBPrewarmer.enabled && MaxCardinality)
+        TBPrewarmer.start();
 }
 
+// Called after every change to the "SyzygyPrewarm" UCI option. Prewarming
+// runs in the background and is restarted whenever the tables are reloaded.
+void Tablebases::set_prewarm(bool enabled) {
+
+    TBPrewarmer.enabled = enabled;
+
+    if (!enabled)
+        TBPrewarmer.stop();
+
+    else if (MaxCardinality)
+        TBPrewarmer.start();
+}
+
+// Called at startup and after every change to the "SyzygyCache" UCI option
+// to resize the cache of probe results. A size of zero disables it.
+void Tablebases::resize_probe_cache(size_t mbSize) { TBProbeCache.resize(mbSize); }
+
 // Probe the WDL table for a particular position.
 // If *result != FAIL, the probe was successful.
 // The return value is from the point of view of the side to move:
@@ -1495,39 +1729,26 @@ void Tablebases::init(const std::string& paths) {
 //  0 : draw
 //  1 : win, but draw under 50-move rule
 //  2 : win
-WDLScore Tablebases::probe_wdl(Position& pos, ProbeState* result) {
+WDLScore Tablebases::probe_wdl(Position& pos, ProbeState* result, ProbeCacheStats* stats) {
+
+    const Key key = pos.state()->key;
+    int       value;
+
+    if (TBProbeCache.enabled() && TBProbeCache.probe(key, value, *result, stats))
+        return WDLScore(value);
 
-    *result = OK;
-    return search<false>(pos, result);
+    *result      = OK;
+    WDLScore wdl = search<false>(pos, result);
+
+    if (TBProbeCache.enabled() && *result != FAIL)
+        TBProbeCache.save(key, wdl, *result);
+
+    return wdl;
 }
 
-// Probe the DTZ table for a particular position.
-// If *result != FAIL, the probe was successful.
-// The return value is from the point of view of the side to move:
-//         n < -100 : loss, but draw under 50-move rule
-// -100 <= n < -1   : loss in n ply (assuming 50-move counter == 0)
-//        -1        : loss, the side to move is mated
-//         0        : draw
-//     1 < n <= 100 : win in n ply (assuming 50-move counter == 0)
-//   100 < n        : win, but draw under 50-move rule
-//
-// The return value n can be off by 1: a return value -n can mean a loss
-// in n+1 ply and a return value +n can mean a win in n+1 ply. This
-// cannot happen for tables with positions exactly on the "edge" of
-// the 50-move rule.
-//
-// This implies that if dtz > 0 is returned, the position is certainly
-// a win if dtz + 50-move-counter <= 99. Care must be taken that the engine
-// picks moves that preserve dtz + 50-move-counter <= 99.
-//
-// If n = 100 immediately after a capture or pawn move, then the position
-// is also certainly a win, and during the whole phase until the next
-// capture or pawn move, the inequality to be preserved is
-// dtz + 50-move-counter <= 100.
-//
-// In short, if a move is available resulting in dtz + 50-move-counter <= 99,
-// then do not accept moves leading to dtz + 50-move-counter == 100.
-int Tablebases::probe_dtz(Position& pos, ProbeState* result) {
+// Probe the DTZ table for a particular position, bypassing the probe cache.
+// Recursive calls go through probe_dtz() and so are cached.
+static int probe_dtz_uncached(Position& pos, ProbeState* result) {
 
     *result      = OK;
     WDLScore wdl = search<true>(pos, result);
@@ -1588,6 +1809,52 @@ int Tablebases::probe_dtz(Position& pos, ProbeState* result) {
     return minDTZ == 0xFFFF ? -1 : minDTZ;
 }
 
+// Probe the DTZ table for a particular position.
+// If *result != FAIL, the probe was successful.
+// The return value is from the point of view of the side to move:
+//         n < -100 : loss, but draw under 50-move rule
+// -100 <= n < -1   : loss in n ply (assuming 50-move counter == 0)
+//        -1        : loss, the side to move is mated
+//         0        : draw
+//     1 < n <= 100 : win in n ply (assuming 50-move counter == 0)
+//   100 < n        : win, but draw under 50-move rule
+//
+// The return value n can be off by 1: a return value -n can mean a loss
+// in n+1 ply and a return value +n can mean a win in n+1 ply. This
+// cannot happen for tables with positions exactly on the "edge" of
+// the 50-move rule.
+//
+// This implies that if dtz > 0 is returned, the position is certainly
+// a win if dtz + 50-move-counter <= 99. Care must be taken that the engine
+// picks moves that preserve dtz + 50-move-counter <= 99.
+//
+// If n = 100 immediately after a capture or pawn move, then the position
+// is also certainly a win, and during the whole phase until the next
+// capture or pawn move, the inequality to be preserved is
+// dtz + 50-move-counter <= 100.
+//
+// In short, if a move is available resulting in dtz + 50-move-counter <= 99,
+// then do not accept moves leading to dtz + 50-move-counter == 100.
+int Tablebases::probe_dtz(Position& pos, ProbeState* result) {
+
+    if (!TBProbeCache.enabled())
+        return probe_dtz_uncached(pos, result);
+
+    const Key key = pos.state()->key ^ ProbeCache::DTZSalt;
+    int       dtz;
+
+    if (TBProbeCache.probe(key, dtz, *result, nullptr))
+        return dtz;
+
+    dtz = probe_dtz_uncached(pos, result);
+
+    if (*result != FAIL)
+        TBProbeCache.save(key, dtz, *result);
+
+    return dtz;
+}
+
+
 
 // Use the DTZ tables to rank root moves.
 //
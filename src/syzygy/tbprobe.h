@@ -19,6 +19,8 @@
 #ifndef TBPROBE_H
 #define TBPROBE_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -60,12 +62,21 @@ enum ProbeState {
     ZEROING_BEST_MOVE = 2    // Best move zeroes DTZ (capture or pawn move)
 };
 
+// Number of lookups and hits of the probe result cache, counted by each
+// search thread for its own probes
+struct ProbeCacheStats {
+    uint64_t lookups;
+    uint64_t hits;
+};
+
 extern int MaxCardinality;
 
 
 void     init(const std::string& paths);
-WDLScore probe_wdl(Position& pos, ProbeState* result);
+void     set_prewarm(bool enabled);
+WDLScore probe_wdl(Position& pos, ProbeState* result, ProbeCacheStats* stats = nullptr);
 int      probe_dtz(Position& pos, ProbeState* result);
+void     resize_probe_cache(size_t mbSize);
 bool     root_probe(Position& pos, Search::RootMoves& rootMoves, bool rule50, bool rankDTZ);
 bool     root_probe_wdl(Position& pos, Search::RootMoves& rootMoves, bool rule50);
 Config   rank_root_moves(const OptionsMap&  options,
@@ -20,12 +20,22 @@
 
 #include <algorithm>
 #include <cassert>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
 
+#if defined(__linux__) && !defined(__ANDROID__)
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
 #include "memory.h"
 #include "movegen.h"
 #include "search.h"
@@ -37,18 +47,65 @@
 
 namespace Sugar {
 
+namespace Futex {
+
+#if defined(__linux__) && !defined(__ANDROID__)
+
+void wait(std::atomic<uint32_t>& word, uint32_t expected, uint32_t bits) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_BITSET_PRIVATE, expected,
+            nullptr, nullptr, bits);
+}
+
+void wake(std::atomic<uint32_t>& word, uint32_t bits) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_BITSET_PRIVATE, INT_MAX,
+            nullptr, nullptr, bits);
+}
+
+#else
+
+namespace {
+
+struct Bucket {
+    std::mutex              mutex;
+    std::condition_variable cv;
+};
+
+Bucket& bucket_of(const std::atomic<uint32_t>& word) {
+    static Bucket buckets[64];
+    return buckets[(reinterpret_cast<std::uintptr_t>(&word) / sizeof(word)) % 64];
+}
+
+}  // namespace
+
+void wait(std::atomic<uint32_t>& word, uint32_t expected, uint32_t) {
+    Bucket&                      b = bucket_of(word);
+    std::unique_lock<std::mutex> lk(b.mutex);
+    if (word.load() == expected)
+        b.cv.wait(lk);
+}
+
+void wake(std::atomic<uint32_t>& word, uint32_t) {
+    Bucket& b = bucket_of(word);
+    { std::lock_guard<std::mutex> lk(b.mutex); }
+    b.cv.notify_all();
+}
+
+#endif
+
+}  // namespace Futex
+
 // Constructor launches the thread and waits until it goes to sleep
-// in idle_loop(). Note that 'searching' and 'exit' should be already set.
+// in idle_loop(). Note that 'state' and 'exit' should be already set.
 Thread::Thread(Search::SharedState&                    sharedState,
                std::unique_ptr<Search::ISearchManager> sm,
                size_t                                  n,
                OptionalThreadToNumaNodeBinder          binder) :
     idx(n),
     nthreads(sharedState.options["Threads"]),
+    wakeWord(sharedState.threads.wakeWord),
+    state(Idle),
     stdThread(&Thread::idle_loop, this) {
 
-    wait_for_search_finished();
-
     run_custom_job([this, &binder, &sharedState, &sm, n]() {
         // Use the binder to [maybe] bind the threads to a NUMA node before doing
         // the Worker allocation. Ideally we would also allocate the SearchManager
@@ -66,10 +123,10 @@ Thread::Thread(Search::SharedState&                    sharedState,
 // for its termination. Thread should be already waiting.
 Thread::~Thread() {
 
-    assert(!searching);
+    assert(state == Idle);
 
     exit = true;
-    start_searching();
+    run_custom_job(nullptr);
     stdThread.join();
 }
 
@@ -85,36 +142,49 @@ void Thread::clear_worker() {
     run_custom_job([this]() { worker->clear(); });
 }
 
-// Blocks on the condition variable until the thread has finished searching
+// Sleeps until the thread has finished its job
 void Thread::wait_for_search_finished() {
 
-    std::unique_lock<std::mutex> lk(mutex);
-    cv.wait(lk, [&] { return !searching; });
+    for (uint32_t s = state.load(); s != Idle; s = state.load())
+    {
+        if (s == Busy && !state.compare_exchange_weak(s, BusyWaited))
+            continue;
+
+        Futex::wait(state, BusyWaited);
+    }
+}
+
+void Thread::post_job(std::function<void()> f) {
+    wait_for_search_finished();
+    jobFunc = std::move(f);
+    state   = Busy;
 }
 
-// Launching a function in the thread
+// Launching a function in the thread. The other threads that share its wake
+// bit wake up too, and go back to sleep.
 void Thread::run_custom_job(std::function<void()> f) {
-    {
-        std::unique_lock<std::mutex> lk(mutex);
-        cv.wait(lk, [&] { return !searching; });
-        jobFunc   = std::move(f);
-        searching = true;
-    }
-    cv.notify_one();
+    post_job(std::move(f));
+    wakeWord.fetch_add(1);
+    Futex::wake(wakeWord, wake_bit());
 }
 
 void Thread::ensure_network_replicated() { worker->ensure_network_replicated(); }
 
-// Thread gets parked here, blocked on the condition variable
+// Thread gets parked here, sleeping on the generation counter of the pool
 // when the thread has no work to do.
 
 void Thread::idle_loop() {
     while (true)
     {
-        std::unique_lock<std::mutex> lk(mutex);
-        searching = false;
-        cv.notify_one();  // Wake up anyone waiting for search finished
-        cv.wait(lk, [&] { return searching; });
+        // Read the generation first: a job posted after the check of the state
+        // bumps it, then the wait returns at once
+        const uint32_t generation = wakeWord.load();
+
+        if (state.load() == Idle)
+        {
+            Futex::wait(wakeWord, generation, wake_bit());
+            continue;
+        }
 
         if (exit)
             return;
@@ -122,60 +192,230 @@ void Thread::idle_loop() {
         std::function<void()> job = std::move(jobFunc);
         jobFunc                   = nullptr;
 
-        lk.unlock();
-
         if (job)
             job();
+
+        if (state.exchange(Idle) == BusyWaited)
+            Futex::wake(state);  // Wake up anyone waiting for search finished
     }
 }
 
+// Starts the jobs posted to the idle threads with a single wakeup
+void ThreadPool::wake_all() {
+    wakeWord.fetch_add(1);
+    Futex::wake(wakeWord);
+}
+
 Search::SearchManager* ThreadPool::main_manager() { return main_thread()->worker->main_manager(); }
 
-uint64_t ThreadPool::nodes_searched() const { return accumulate(&Search::Worker::nodes); }
+std::vector<std::atomic<uint64_t>*>
+NodeCounter::assign(const std::vector<NumaIndex>& threadToNumaNode) {
+
+    // Threads of the same NUMA node are grouped in order, a new shard is
+    // started for every ThreadsPerShard threads of a node.
+    std::vector<size_t> shardOfThread(threadToNumaNode.size());
+    std::unordered_map<NumaIndex, std::pair<size_t, size_t>> open;  // shard, threads
+    shardCount = 0;
+
+    for (size_t i = 1; i < threadToNumaNode.size(); ++i)
+    {
+        auto it = open.find(threadToNumaNode[i]);
+
+        if (it == open.end() || it->second.second == ThreadsPerShard)
+            it = open.insert_or_assign(threadToNumaNode[i], std::make_pair(shardCount++, 0))
+                   .first;
+
+        shardOfThread[i] = it->second.first;
+        it->second.second++;
+    }
+
+    shards = std::make_unique<Shard[]>(shardCount);
+    clear();
+
+    std::vector<std::atomic<uint64_t>*> result(threadToNumaNode.size(), nullptr);
+    for (size_t i = 1; i < threadToNumaNode.size(); ++i)
+        result[i] = &shards[shardOfThread[i]].nodes;
+
+    return result;
+}
+
+void NodeCounter::clear() {
+    for (size_t i = 0; i < shardCount; ++i)
+        shards[i].nodes.store(0, std::memory_order_relaxed);
+}
+
+uint64_t NodeCounter::sum() const {
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < shardCount; ++i)
+        total += shards[i].nodes.load(std::memory_order_relaxed);
+    return total;
+}
+
+void MultiPVLines::clear() {
+    for (auto& line : lines)
+        line.store(0, std::memory_order_relaxed);
+}
+
+// Keeps the deeper result, or the newer one of the same depth
+void MultiPVLines::publish(size_t line, Move m, Value v, Depth d) {
+    assert(line < MaxLines && d > 0);
+
+    const uint64_t packed =
+      uint64_t(uint16_t(d)) << 48 | uint64_t(m.raw()) << 32 | uint32_t(int32_t(v));
+    uint64_t current = lines[line].load(std::memory_order_relaxed);
+
+    while (Depth(current >> 48) <= d
+           && !lines[line].compare_exchange_weak(current, packed, std::memory_order_relaxed))
+    {}
+}
+
+MultiPVLines::Line MultiPVLines::get(size_t line) const {
+    assert(line < MaxLines);
+
+    const uint64_t packed = lines[line].load(std::memory_order_relaxed);
+    return {Move(uint16_t(packed >> 32)), Value(int32_t(uint32_t(packed))), Depth(packed >> 48)};
+}
+
+uint64_t NodeCounter::batch_mask(uint64_t nodesLimit, size_t threadCount) {
+
+    uint64_t batch = MaxBatch;
+
+    if (nodesLimit)
+        while (batch > 1 && batch * threadCount * 1024 > nodesLimit)
+            batch /= 2;
+
+    return batch - 1;
+}
+
+// Returns the nodes searched by all threads. The count of the main thread is
+// exact, the ones of the helpers are read from the shards and may lag behind
+// by less than a batch per helper while searching. Once the helpers finished
+// their search the result is exact.
+uint64_t ThreadPool::nodes_searched() const {
+    return main_thread()->worker->nodes.load(std::memory_order_relaxed) + nodeCounter.sum();
+}
+
+// Exact count of the nodes searched, visiting every worker
+uint64_t ThreadPool::nodes_searched_by_scan() const { return accumulate(&Search::Worker::nodes); }
 uint64_t ThreadPool::tb_hits() const { return accumulate(&Search::Worker::tbHits); }
 
+// Threads that have searched a node since the search started
+size_t ThreadPool::searching_threads() const {
+    return size_t(std::count_if(threads.begin(), threads.end(), [](const auto& th) {
+        return th->worker->nodes.load(std::memory_order_relaxed) > 0;
+    }));
+}
+
+// Returns the lookups and hits of the eval caches of all threads. Must not be
+// called while searching.
+std::pair<uint64_t, uint64_t> ThreadPool::eval_cache_stats() const {
+
+    uint64_t lookups = 0, hits = 0;
+    for (auto&& th : threads)
+    {
+        lookups += th->worker->evalCache.lookups;
+        hits += th->worker->evalCache.hits;
+    }
+    return {lookups, hits};
+}
+
+// Returns the lookups and hits of the TB probe cache by the searches of all
+// threads. Must not be called while searching.
+std::pair<uint64_t, uint64_t> ThreadPool::tb_cache_stats() const {
+
+    uint64_t lookups = 0, hits = 0;
+    for (auto&& th : threads)
+    {
+        lookups += th->worker->tbCacheStats.lookups;
+        hits += th->worker->tbCacheStats.hits;
+    }
+    return {lookups, hits};
+}
+
 // Creates/destroys threads to match the requested number.
 // Created and launched threads will immediately go to sleep in idle_loop.
-// Upon resizing, threads are recreated to allow for binding if necessary.
-void ThreadPool::set(const NumaConfig&                           numaConfig,
+// Upon resizing, the existing threads are kept with their histories when their
+// binding stays the same, only the missing threads are created or the extra
+// ones destroyed. Otherwise, as after a change of the NUMA configuration, all
+// the threads are recreated. Returns true in the latter case.
+bool ThreadPool::set(const NumaConfig&                           numaConfig,
                      Search::SharedState                         sharedState,
-                     const Search::SearchManager::UpdateContext& updateContext) {
+                     const Search::SearchManager::UpdateContext& updateContext,
+                     size_t                                      threadCount) {
+
+    const size_t requested = threadCount ? threadCount : size_t(sharedState.options["Threads"]);
+
+    // Binding threads may be problematic when there's multiple NUMA nodes and
+    // multiple Sugar instances running. In particular, if each instance
+    // runs a single thread then they would all be mapped to the first NUMA node.
+    // This is undesirable, and so the default behaviour (i.e. when the user does not
+    // change the NumaConfig UCI setting) is to not bind the threads to processors
+    // unless we know for sure that we span NUMA nodes and replication is required.
+    const std::string numaPolicy(sharedState.options["NumaPolicy"]);
+    const bool        doBindThreads = [&]() {
+        if (numaPolicy == "none")
+            return false;
+
+        if (numaPolicy == "auto")
+            return numaConfig.suggests_binding_threads(requested);
+
+        // numaPolicy == "system", or explicitly set by the user
+        return true;
+    }();
+
+    std::vector<NumaIndex> threadToNumaNode =
+      doBindThreads ? numaConfig.distribute_threads_among_numa_nodes(requested)
+                    : std::vector<NumaIndex>{};
+
+    // Without NUMA binding the threads may be pinned one per physical core,
+    // SMT siblings being used only once every core has a thread. Threads are
+    // left free when there are more of them than processors.
+    std::vector<CpuIndex> threadToCpu;
+
+    if (!doBindThreads && std::string(sharedState.options["Thread Placement"]) == "cores")
+    {
+        threadToCpu = numaConfig.cpus_by_physical_core();
+
+        if (threadToCpu.size() < requested)
+            threadToCpu.clear();
+        else
+            threadToCpu.resize(requested);
+    }
 
-    if (threads.size() > 0)  // destroy any existing thread(s)
+    // The threads that are kept must be bound as they would be if created now
+    auto same_prefix = [](const auto& a, const auto& b) {
+        const size_t n = std::min(a.size(), b.size());
+        return a.empty() == b.empty() && std::equal(a.begin(), a.begin() + n, b.begin());
+    };
+
+    const std::string numaConfigStr = numaConfig.to_string();
+    const bool keep = !threads.empty() && requested > 0 && numaConfigStr == createdNumaConfig
+                   && &sharedState.options == createdWith.options
+                   && &sharedState.tt == createdWith.tt
+                   && &sharedState.networks == createdWith.networks
+                   && &updateContext == createdWith.updateContext
+                   && same_prefix(threadToNumaNode, boundThreadToNumaNode)
+                   && same_prefix(threadToCpu, boundThreadToCpu);
+
+    if (threads.size() > 0)
     {
         main_thread()->wait_for_search_finished();
+        wait_for_search_finished();
 
-        threads.clear();
-
-        boundThreadToNumaNode.clear();
+        if (!keep)  // destroy any existing thread(s)
+            threads.clear();
+        else if (threads.size() > requested)
+            threads.resize(requested);
     }
 
-    const size_t requested = sharedState.options["Threads"];
+    boundThreadToNumaNode = std::move(threadToNumaNode);
+    boundThreadToCpu      = std::move(threadToCpu);
+    createdNumaConfig     = numaConfigStr;
+    createdWith = {&sharedState.options, &sharedState.tt, &sharedState.networks, &updateContext};
 
     if (requested > 0)  // create new thread(s)
     {
-        // Binding threads may be problematic when there's multiple NUMA nodes and
-        // multiple Sugar instances running. In particular, if each instance
-        // runs a single thread then they would all be mapped to the first NUMA node.
-        // This is undesirable, and so the default behaviour (i.e. when the user does not
-        // change the NumaConfig UCI setting) is to not bind the threads to processors
-        // unless we know for sure that we span NUMA nodes and replication is required.
-        const std::string numaPolicy(sharedState.options["NumaPolicy"]);
-        const bool        doBindThreads = [&]() {
-            if (numaPolicy == "none")
-                return false;
-
-            if (numaPolicy == "auto")
-                return numaConfig.suggests_binding_threads(requested);
-
-            // numaPolicy == "system", or explicitly set by the user
-            return true;
-        }();
-
-        boundThreadToNumaNode = doBindThreads
-                                ? numaConfig.distribute_threads_among_numa_nodes(requested)
-                                : std::vector<NumaIndex>{};
-
         while (threads.size() < requested)
         {
             const size_t    threadId = threads.size();
@@ -189,16 +429,28 @@ void ThreadPool::set(const NumaConfig&                           numaConfig,
             // accesses we don't want to trash cache in case the threads get scheduled
             // on the same NUMA node.
             auto binder = doBindThreads ? OptionalThreadToNumaNodeBinder(numaConfig, numaId)
-                                        : OptionalThreadToNumaNodeBinder(numaId);
+                        : !boundThreadToCpu.empty()
+                          ? OptionalThreadToNumaNodeBinder(numaConfig, numaId, boundThreadToCpu[threadId])
+                          : OptionalThreadToNumaNodeBinder(numaId);
 
             threads.emplace_back(
               std::make_unique<Thread>(sharedState, std::move(manager), threadId, binder));
         }
 
-        clear();
+        const auto nodesShards = nodeCounter.assign(
+          doBindThreads ? boundThreadToNumaNode : std::vector<NumaIndex>(requested, 0));
+
+        for (size_t i = 0; i < requested; ++i)
+            threads[i]->worker->nodesShard = nodesShards[i];
+
+        // New workers start cleared, the kept ones keep their histories
+        if (!keep)
+            clear();
 
         main_thread()->wait_for_search_finished();
     }
+
+    return !keep;
 }
 
 
@@ -207,11 +459,12 @@ void ThreadPool::clear() {
     if (threads.size() == 0)
         return;
 
-    for (auto&& th : threads)
-        th->clear_worker();
-
-    for (auto&& th : threads)
-        th->wait_for_search_finished();
+    // One worker per item, so that each thread clears its own histories unless
+    // it is late to wake up
+    parallel_for(threads.size(), 1, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            threads[i]->worker->clear();
+    });
 
     // These two affect the time taken on the first move of a game:
     main_manager()->bestPreviousAverageScore = VALUE_INFINITE;
@@ -233,6 +486,64 @@ void ThreadPool::wait_on_thread(size_t threadId) {
     threads[threadId]->wait_for_search_finished();
 }
 
+// Calls f(begin, end) over [0, count) in chunks of at most grain items, on the
+// threads of the pool, and returns once all of them are done. The range is
+// split evenly and every thread first works through its own part, so that the
+// memory it touches stays on its NUMA node, then takes chunks from the parts
+// still in progress, on its own node first. Must not be called while searching.
+void ThreadPool::parallel_for(size_t                                     count,
+                              size_t                                     grain,
+                              const std::function<void(size_t, size_t)>& f) {
+
+    if (threads.empty())
+    {
+        if (count)
+            f(0, count);
+        return;
+    }
+
+    grain          = std::max(grain, size_t(1));
+    const size_t n = std::clamp((count + grain - 1) / grain, size_t(1), threads.size());
+
+    struct alignas(64) Part {
+        std::atomic<size_t> next;
+        size_t              end;
+    };
+
+    auto parts = std::make_unique<Part[]>(n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        parts[i].next = count * i / n;
+        parts[i].end  = count * (i + 1) / n;
+    }
+
+    auto work = [&](size_t p) {
+        for (size_t begin; (begin = parts[p].next.fetch_add(grain, std::memory_order_relaxed))
+                           < parts[p].end;)
+            f(begin, std::min(begin + grain, parts[p].end));
+    };
+
+    auto node = [&](size_t i) {
+        return boundThreadToNumaNode.empty() ? NumaIndex(0) : boundThreadToNumaNode[i];
+    };
+
+    for (size_t i = 0; i < n; ++i)
+        threads[i]->post_job([&, i]() {
+            work(i);
+
+            for (bool sameNode : {true, false})
+                for (size_t k = 1; k < n; ++k)
+                    if ((node((i + k) % n) == node(i)) == sameNode)
+                        work((i + k) % n);
+        });
+
+    wake_all();
+
+    for (size_t i = 0; i < n; ++i)
+        threads[i]->wait_for_search_finished();
+}
+
 size_t ThreadPool::num_threads() const { return threads.size(); }
 
 
@@ -245,7 +556,7 @@ void ThreadPool::start_thinking(const OptionsMap&  options,
 
     main_thread()->wait_for_search_finished();
 
-    main_manager()->stopOnPonderhit = stop = abortedSearch = false;
+    main_manager()->stopOnPonderhit = stop = abortedSearch = nodesLimitArmed = false;
     main_manager()->ponder                                 = limits.ponderMode;
 
     increaseDepth = true;
@@ -267,24 +578,45 @@ void ThreadPool::start_thinking(const OptionsMap&  options,
 
     Tablebases::Config tbConfig = Tablebases::rank_root_moves(options, pos, rootMoves);
 
-    // After ownership transfer 'states' becomes empty, so if we stop the search
-    // and call 'go' again without setting a new position states.get() == nullptr.
+    // The states are shared with the caller, which may later append the moves
+    // of the next position command to them. This does not affect the search:
+    // deque elements are never moved and the search only reads earlier ones.
     assert(states.get() || setupStates.get());
 
     if (states.get())
-        setupStates = std::move(states);  // Ownership transfer, states is now empty
+        setupStates = states;
 
     // We use Position::set() to set root position across threads. But there are
     // some StateInfo fields (previous, pliesFromNull, capturedPiece) that cannot
     // be deduced from a fen string, so set() clears them and they are set from
     // setupStates->back() later. The rootState is per thread, earlier states are
     // shared since they are read-only.
+    nodeCounter.clear();
+    multiPVLines.clear();
+
+    const Search::Skill skill(options["Skill Level"],
+                              options["UCI_LimitStrength"] ? int(options["UCI_Elo"]) : 0);
+    const bool          skillBudget =
+      skill.enabled() && bool(options["Skill Budget"]) && !bool(options["UCI_LimitStrength"]);
+
+    if (skillBudget && (!limits.nodes || limits.nodes > skill.node_budget()))
+        limits.nodes = skill.node_budget();
+
+    const uint64_t nodesBatchMask = NodeCounter::batch_mask(limits.nodes, threads.size());
+
     for (auto&& th : threads)
     {
-        th->run_custom_job([&]() {
+        th->post_job([&]() {
             th->worker->limits = limits;
             th->worker->nodes = th->worker->tbHits = th->worker->nmpMinPly =
               th->worker->bestMoveChanges          = 0;
+            th->worker->nodesBatchMask             = nodesBatchMask;
+            th->worker->nnuePrefetch               = bool(options["NNUE Prefetch"]);
+            th->worker->fastMultiPV                = bool(options["Fast MultiPV"]);
+            th->worker->skillBudget                = skillBudget;
+            th->worker->smallNetOnly               = skillBudget && skill.small_net_only();
+            th->worker->expPrefill                 = bool(options["Experience Prefill"]);
+            th->worker->expPrefillPlies            = int(options["Experience Prefill Plies"]);
             th->worker->rootDepth = th->worker->completedDepth = 0;
             th->worker->rootMoves                              = rootMoves;
             th->worker->rootPos.set(pos.fen(), pos.is_chess960(), &th->worker->rootState);
@@ -293,6 +625,8 @@ void ThreadPool::start_thinking(const OptionsMap&  options,
         });
     }
 
+    wake_all();
+
     for (auto&& th : threads)
         th->wait_for_search_finished();
 
@@ -366,19 +700,32 @@ Thread* ThreadPool::get_best_thread() const {
 }
 
 
-// Start non-main threads.
+// Start non-main threads, all with the same wakeup.
 // Will be invoked by main thread after it has started searching.
 void ThreadPool::start_searching() {
 
+    helpersSearching = uint32_t(threads.size() - 1);
+
     for (auto&& th : threads)
         if (th != threads.front())
-            th->start_searching();
+            th->post_job([this, th = th.get()]() {
+                th->worker->start_searching();
+
+                if (helpersSearching.fetch_sub(1) == 1)
+                    Futex::wake(helpersSearching);
+            });
+
+    wake_all();
 }
 
 
-// Wait for non-main threads
+// Wait for non-main threads. After a search, this sleeps until the last helper
+// is done with a single wakeup, then the helpers are idle or about to be.
 void ThreadPool::wait_for_search_finished() const {
 
+    for (uint32_t n = helpersSearching.load(); n != 0; n = helpersSearching.load())
+        Futex::wait(helpersSearching, n);
+
     for (auto&& th : threads)
         if (th != threads.front())
             th->wait_for_search_finished();
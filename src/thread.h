@@ -20,12 +20,13 @@
 #define THREAD_H_INCLUDED
 
 #include <atomic>
-#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
-#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "memory.h"
@@ -54,23 +55,48 @@ class OptionalThreadToNumaNodeBinder {
         numaConfig(&cfg),
         numaId(n) {}
 
+    // Pins the thread to a single processor instead, for the core placement
+    // used when the threads are not bound to NUMA nodes
+    OptionalThreadToNumaNodeBinder(const NumaConfig& cfg, NumaIndex n, CpuIndex c) :
+        numaConfig(&cfg),
+        numaId(n),
+        cpu(c) {}
+
     NumaReplicatedAccessToken operator()() const {
-        if (numaConfig != nullptr)
+        if (numaConfig != nullptr && cpu.has_value())
+        {
+            numaConfig->bind_current_thread_to_cpu(*cpu);
+            return NumaReplicatedAccessToken(numaId);
+        }
+        else if (numaConfig != nullptr)
             return numaConfig->bind_current_thread_to_numa_node(numaId);
         else
             return NumaReplicatedAccessToken(numaId);
     }
 
    private:
-    const NumaConfig* numaConfig;
-    NumaIndex         numaId;
+    const NumaConfig*       numaConfig;
+    NumaIndex               numaId;
+    std::optional<CpuIndex> cpu;
 };
 
+// Minimal futex: wait() sleeps while the word holds the expected value, wake()
+// wakes all the waiters on the word. On Linux only the waiters whose bits
+// intersect the given ones are woken. Elsewhere the waiters share condition
+// variables and all wake up; a spurious wakeup is always possible.
+namespace Futex {
+void wait(std::atomic<uint32_t>& word, uint32_t expected, uint32_t bits = ~0u);
+void wake(std::atomic<uint32_t>& word, uint32_t bits = ~0u);
+}
+
 // Abstraction of a thread. It contains a pointer to the worker and a native thread.
 // After construction, the native thread is started with idle_loop()
 // waiting for a signal to start searching.
 // When the signal is received, the thread starts searching and when
 // the search is finished, it goes back to idle_loop() waiting for a new signal.
+// The idle threads of a pool all sleep on the same generation counter, so that
+// a job posted to each of them is started by a single wakeup, see
+// ThreadPool::wake_all().
 class Thread {
    public:
     Thread(Search::SharedState&,
@@ -83,6 +109,8 @@ class Thread {
     void start_searching();
     void clear_worker();
     void run_custom_job(std::function<void()> f);
+    // Hands the job to the thread without waking it up
+    void post_job(std::function<void()> f);
 
     void ensure_network_replicated();
 
@@ -98,15 +126,81 @@ class Thread {
     std::function<void()>        jobFunc;
 
    private:
-    std::mutex                mutex;
-    std::condition_variable   cv;
+    // Busy from the posting of a job until it is done, BusyWaited when someone
+    // sleeps on the state waiting for that
+    enum State : uint32_t {
+        Idle,
+        Busy,
+        BusyWaited
+    };
+
+    uint32_t wake_bit() const { return 1u << (idx % 32); }
+
     size_t                    idx, nthreads;
-    bool                      exit = false, searching = true;  // Set before starting std::thread
+    std::atomic<uint32_t>&    wakeWord;  // Generation counter of the pool
+    std::atomic<uint32_t>     state;
+    bool                      exit = false;
     NativeThread              stdThread;
     NumaReplicatedAccessToken numaAccessToken;
 };
 
 
+// NodeCounter aggregates the node counts of the helper threads into a few
+// cache-line sized shards, one per group of threads on the same NUMA node, so
+// that reading the total does not touch the cache line of every worker. The
+// helpers publish their nodes in batches of a power of two, so the total lags
+// behind by less than one batch per helper thread.
+class NodeCounter {
+   public:
+    static constexpr size_t ThreadsPerShard = 16;
+    static constexpr size_t MaxBatch        = 1024;
+
+    // Sets up the shards for the given NUMA node of each thread and returns
+    // the shard of each thread, nullptr for the main thread which is not
+    // aggregated: its own count is always read directly.
+    std::vector<std::atomic<uint64_t>*> assign(const std::vector<NumaIndex>& threadToNumaNode);
+
+    void     clear();
+    uint64_t sum() const;
+
+    // Returns the batch size mask to use for a search, such that with a nodes
+    // limit the total lags behind by at most about 0.1% of the limit.
+    static uint64_t batch_mask(uint64_t nodesLimit, size_t threadCount);
+
+   private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> nodes;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    size_t                   shardCount = 0;
+};
+
+
+// MultiPVLines shares the MultiPV lines between the threads of a Fast MultiPV
+// search: for every line, the move, score and depth of the deepest result any
+// thread found for it so far in this search. A line is packed into a single
+// word, so that a reader never sees the move of one result with the score of
+// another.
+class MultiPVLines {
+   public:
+    static constexpr size_t MaxLines = 256;
+
+    struct Line {
+        Move  move;
+        Value score;
+        Depth depth;  // 0 if nothing was published for the line
+    };
+
+    void clear();
+    void publish(size_t line, Move m, Value v, Depth d);
+    Line get(size_t line) const;
+
+   private:
+    std::atomic<uint64_t> lines[MaxLines] = {};
+};
+
+
 // ThreadPool struct handles all the threads-related stuff like init, starting,
 // parking and, most importantly, launching a thread. All the access to threads
 // is done through this class.
@@ -133,25 +227,36 @@ class ThreadPool {
     void   start_thinking(const OptionsMap&, Position&, StateListPtr&, Search::LimitsType);
     void   run_on_thread(size_t threadId, std::function<void()> f);
     void   wait_on_thread(size_t threadId);
+    void   parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)>& f);
     size_t num_threads() const;
     void   clear();
-    void   set(const NumaConfig& numaConfig,
+    // A non-zero threadCount overrides the "Threads" option
+    bool   set(const NumaConfig& numaConfig,
                Search::SharedState,
-               const Search::SearchManager::UpdateContext&);
+               const Search::SearchManager::UpdateContext&,
+               size_t threadCount = 0);
 
     Search::SearchManager* main_manager();
     Thread*                main_thread() const { return threads.front().get(); }
     uint64_t               nodes_searched() const;
+    uint64_t               nodes_searched_by_scan() const;
     uint64_t               tb_hits() const;
+    size_t                 searching_threads() const;
+    std::pair<uint64_t, uint64_t> eval_cache_stats() const;
+    std::pair<uint64_t, uint64_t> tb_cache_stats() const;
     Thread*                get_best_thread() const;
     void                   start_searching();
     void                   wait_for_search_finished() const;
 
-    std::vector<size_t> get_bound_thread_count_by_numa_node() const;
+    std::vector<size_t>   get_bound_thread_count_by_numa_node() const;
+    std::vector<CpuIndex> get_bound_thread_cpus() const { return boundThreadToCpu; }
 
     void ensure_network_replicated();
 
-    std::atomic_bool stop, abortedSearch, increaseDepth;
+    std::atomic_bool stop, abortedSearch, increaseDepth, nodesLimitArmed;
+    MultiPVLines     multiPVLines;
+
+    friend class Thread;
 
     auto cbegin() const noexcept { return threads.cbegin(); }
     auto begin() noexcept { return threads.begin(); }
@@ -161,9 +266,28 @@ class ThreadPool {
     auto empty() const noexcept { return threads.empty(); }
 
    private:
+    // The idle threads sleep on wakeWord, which is bumped for every wakeup.
+    // helpersSearching counts down as the helpers finish their search, the
+    // last one wakes up the main thread waiting for them.
+    std::atomic<uint32_t>         wakeWord{0};
+    mutable std::atomic<uint32_t> helpersSearching{0};
+
+    void wake_all();
+
     StateListPtr                         setupStates;
     std::vector<std::unique_ptr<Thread>> threads;
     std::vector<NumaIndex>               boundThreadToNumaNode;
+    std::vector<CpuIndex>                boundThreadToCpu;
+
+    // What the current threads were created with, see set()
+    struct {
+        const OptionsMap*                               options       = nullptr;
+        const TranspositionTable*                       tt            = nullptr;
+        const LazyNumaReplicated<Eval::NNUE::Networks>* networks      = nullptr;
+        const Search::SearchManager::UpdateContext*     updateContext = nullptr;
+    } createdWith;
+    std::string createdNumaConfig;
+    NodeCounter                          nodeCounter;
 
     uint64_t accumulate(std::atomic<uint64_t> Search::Worker::* member) const {
 
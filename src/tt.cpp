@@ -149,15 +149,20 @@ struct Cluster {
 static_assert(sizeof(Cluster) == 32, "Suboptimal Cluster size");
 
 
+TranspositionTable::~TranspositionTable() {
+    huge_pages_free(table, clusterCount * sizeof(Cluster), pageSize);
+}
+
+
 // Sets the size of the transposition table,
 // measured in megabytes. Transposition table consists
 // of clusters and each cluster consists of ClusterSize number of TTEntry.
 void TranspositionTable::resize(size_t mbSize, ThreadPool& threads) {
-    aligned_large_pages_free(table);
+    huge_pages_free(table, clusterCount * sizeof(Cluster), pageSize);
 
     clusterCount = mbSize * 1024 * 1024 / sizeof(Cluster);
 
-    table = static_cast<Cluster*>(aligned_large_pages_alloc(clusterCount * sizeof(Cluster)));
+    table = static_cast<Cluster*>(huge_pages_alloc(clusterCount * sizeof(Cluster), pageSize));
 
     if (!table)
     {
@@ -172,23 +177,14 @@ void TranspositionTable::resize(size_t mbSize, ThreadPool& threads) {
 // Initializes the entire transposition table to zero,
 // in a multi-threaded way.
 void TranspositionTable::clear(ThreadPool& threads) {
-    generation8              = 0;
-    const size_t threadCount = threads.num_threads();
+    generation8 = 0;
 
-    for (size_t i = 0; i < threadCount; ++i)
-    {
-        threads.run_on_thread(i, [this, i, threadCount]() {
-            // Each thread will zero its part of the hash table
-            const size_t stride = clusterCount / threadCount;
-            const size_t start  = stride * i;
-            const size_t len    = i + 1 != threadCount ? stride : clusterCount - start;
-
-            std::memset(&table[start], 0, len * sizeof(Cluster));
-        });
-    }
+    // Each thread zeroes its part of the table, then helps the slower ones
+    constexpr size_t Grain = (2 * 1024 * 1024) / sizeof(Cluster);
 
-    for (size_t i = 0; i < threadCount; ++i)
-        threads.wait_on_thread(i);
+    threads.parallel_for(clusterCount, Grain, [this](size_t begin, size_t end) {
+        std::memset(&table[begin], 0, (end - begin) * sizeof(Cluster));
+    });
 }
 
 
@@ -81,7 +81,7 @@ struct TTWriter {
 class TranspositionTable {
 
    public:
-    ~TranspositionTable() { aligned_large_pages_free(table); }
+    ~TranspositionTable();
 
     void resize(size_t mbSize, ThreadPool& threads);  // Set TT size
     void clear(ThreadPool& threads);                  // Re-initialize memory, multithreaded
@@ -90,6 +90,7 @@ class TranspositionTable {
 
     void
     new_search();  // This must be called at the beginning of each root search to track entry aging
+    size_t page_size() const { return pageSize; }  // Huge page size of the table, 0 if unknown
     uint8_t generation() const;  // The current age, used when writing new data to the TT
     std::tuple<bool, TTData, TTWriter>
     probe(const Key key) const;  // The main method, whose retvals separate local vs global objects
@@ -99,8 +100,9 @@ class TranspositionTable {
    private:
     friend struct TTEntry;
 
-    size_t   clusterCount;
-    Cluster* table = nullptr;
+    size_t   clusterCount = 0;
+    Cluster* table        = nullptr;
+    size_t   pageSize     = 0;
 
     uint8_t generation8 = 0;  // Size must be not bigger than TTEntry::genBound8
 };
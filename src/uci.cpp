@@ -20,12 +20,19 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
 #include <iterator>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -34,9 +41,11 @@
 #include "experience.h"
 #include "memory.h"
 #include "movegen.h"
+#include "perft.h"
 #include "position.h"
 #include "score.h"
 #include "search.h"
+#include "syzygy/tbprobe.h"
 #include "types.h"
 #include "ucioption.h"
 
@@ -147,12 +156,44 @@ UCIEngine::UCIEngine(int argc, char** argv) :
 }
 
 void UCIEngine::init_search_update_listeners() {
-    engine.set_on_iter([](const auto& i) { on_iter(i); });
-    engine.set_on_update_no_moves([](const auto& i) { on_update_no_moves(i); });
-    engine.set_on_update_full(
-      [this](const auto& i) { on_update_full(i); });
-    engine.set_on_bestmove([](const auto& bm, const auto& p) { on_bestmove(bm, p); });
+    engine.set_on_iter([this](const auto& i) {
+        if (output.enabled())
+            output.push(i);
+        else
+            on_iter(i);
+    });
+    engine.set_on_update_no_moves([this](const auto& i) {
+        if (output.enabled())
+            output.push(i);
+        else
+            on_update_no_moves(i);
+    });
+    engine.set_on_update_full([this](const auto& i) {
+        if (output.enabled())
+            output.push(i);
+        else
+            on_update_full(i);
+    });
+    engine.set_on_bestmove([this](const auto& bm, const auto& p) {
+        if (output.enabled())
+            output.push_bestmove(bm, p);
+        else
+            on_bestmove(bm, p);
+    });
     engine.set_on_verify_networks([](const auto& s) { print_info_string(s); });
+
+    // Sessions print directly, their lines must not wait for the main search
+    engine.get_sessions().set_listener_factory([](const std::string& id) {
+        const std::string prefix = "session " + id + " ";
+
+        return SessionServer::UpdateContext{
+          [prefix](const auto& i) { sync_cout << prefix << format_update_no_moves(i) << sync_endl; },
+          [prefix](const auto& i) { sync_cout << prefix << format_update_full(i) << sync_endl; },
+          [prefix](const auto& i) { sync_cout << prefix << format_iter(i) << sync_endl; },
+          [prefix](const auto& bm, const auto& p) {
+              sync_cout << prefix << format_bestmove(bm, p) << sync_endl;
+          }};
+    });
 }
 
 void UCIEngine::loop() {
@@ -174,6 +215,8 @@ void UCIEngine::loop() {
 
         if (token == "quit" || token == "stop") {
             engine.stop();
+            if (token == "quit")
+                engine.get_sessions().stop_all();
         }
         else if (token == "ponderhit") {
             // The GUI played the expected move: disable ponder
@@ -193,11 +236,21 @@ void UCIEngine::loop() {
 #endif
         }
         else if (token == "go") {
+            // Let the previous search's output reach the GUI before anything new
+            engine.wait_for_search_finished();
+            output.flush();
+            output.set_enabled(engine.get_options()["Async Output"]);
+
             const std::string firstFEN = engine.fen();
 #if defined(SUG_FIXED_ZOBRIST)
             ensure_exp_initialized(engine);
-            if (firstFEN == "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1")
-                Experience::resume_learning();
+            // Sessions probe the Experience store concurrently, see SessionServer
+            if (!engine.get_sessions().size())
+            {
+                if (firstFEN == "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1")
+                    Experience::resume_learning();
+                Experience::refresh();
+            }
 #endif
             print_info_string(engine.numa_config_information_as_string());
             print_info_string(engine.thread_allocation_information_as_string());
@@ -209,11 +262,15 @@ void UCIEngine::loop() {
         else if (token == "ucinewgame") {
 #if defined(SUG_FIXED_ZOBRIST)
             ensure_exp_initialized(engine);
-            Experience::save();
+            // Saving links the new entries into the tables the sessions probe,
+            // so it waits until they are closed, at the latest until quit
+            if (!engine.get_sessions().size())
+                Experience::save();
 #endif
             engine.search_clear();
 #if defined(SUG_FIXED_ZOBRIST)
-            Experience::resume_learning();
+            if (!engine.get_sessions().size())
+                Experience::resume_learning();
 #endif
         }
         else if (token == "isready") {
@@ -221,6 +278,7 @@ void UCIEngine::loop() {
             ensure_exp_initialized(engine);
             Experience::wait_for_loading_finished();
 #endif
+            output.flush();
             sync_cout << "readyok" << sync_endl;
         }
         else if (token == "bench") {
@@ -229,6 +287,27 @@ void UCIEngine::loop() {
         else if (token == BenchmarkCommand) {
             benchmark(is);
         }
+        else if (token == "movegenbench") {
+            movegen_bench(is);
+        }
+        else if (token == "evalbench") {
+            eval_bench(is);
+        }
+        else if (token == "nodesbench") {
+            nodes_bench(is);
+        }
+        else if (token == "poolbench") {
+            pool_bench(is);
+        }
+        else if (token == "threadbench") {
+            thread_bench(is);
+        }
+        else if (token == "selfplay") {
+            selfplay(is);
+        }
+        else if (token == "session") {
+            session(is);
+        }
         else if (token == "d") {
             sync_cout << engine.visualize() << sync_endl;
         }
@@ -429,6 +508,10 @@ void UCIEngine::loop() {
 
     } while (token != "quit");
 
+    engine.wait_for_search_finished();
+    engine.get_sessions().close_all();
+    output.flush();
+
 #if defined(SUG_FIXED_ZOBRIST)
     // Writes to disk what has been collected in RAM
     Experience::save();
@@ -554,6 +637,16 @@ void UCIEngine::bench(std::istream& args) {
               << "\nNodes searched  : " << nodes    //
               << "\nNodes/second    : " << 1000 * nodes / elapsed << std::endl;
 
+    const auto [evalLookups, evalHits] = engine.get_eval_cache_stats();
+    if (evalLookups)
+        std::cerr << "Eval cache hits : " << evalHits << '/' << evalLookups << " ("
+                  << 100 * evalHits / evalLookups << "%)" << std::endl;
+
+    const auto [tbLookups, tbHits] = engine.get_tb_cache_stats();
+    if (tbLookups)
+        std::cerr << "TB cache hits   : " << tbHits << '/' << tbLookups << " ("
+                  << 100 * tbHits / tbLookups << "%)" << std::endl;
+
 #if defined(SUG_FIXED_ZOBRIST)
     // Bench mode OFF
     Experience::g_benchMode.store(false, std::memory_order_relaxed);
@@ -576,7 +669,20 @@ void UCIEngine::benchmark(std::istream& args) {
     uint64_t    nodes = 0, cnt = 1;
     uint64_t    nodesSearched = 0;
 
-    engine.set_on_update_full([&](const Engine::InfoFull& i) { nodesSearched = i.nodes; });
+    // Time at which each depth was completed for all the PV lines of the current
+    // position. A depth is complete when its last line is reported at that depth,
+    // and the line count is known from the first depth, which is always reported
+    // in full.
+    std::vector<TimePoint> depthTime;
+    size_t                 lastLine = 0;
+
+    engine.set_on_update_full([&](const Engine::InfoFull& i) {
+        nodesSearched = i.nodes;
+        lastLine      = std::max(lastLine, i.multiPV);
+
+        if (i.multiPV == lastLine && i.depth >= int(depthTime.size()))
+            depthTime.resize(i.depth + 1, TimePoint(i.timeMs));
+    });
 
     engine.set_on_iter([](const auto&) {});
     engine.set_on_update_no_moves([](const auto&) {});
@@ -595,6 +701,8 @@ void UCIEngine::benchmark(std::istream& args) {
     setoption(ss);
     ss = std::istringstream("name Hash value " + std::to_string(setup.ttSize));
     setoption(ss);
+    ss = std::istringstream("name MultiPV value " + std::to_string(setup.multiPV));
+    setoption(ss);
     ss = std::istringstream("name UCI_Chess960 value false");
     setoption(ss);
 
@@ -654,6 +762,10 @@ void UCIEngine::benchmark(std::istream& args) {
         }
     };
 
+    // Sum and count over the positions of the time to complete each depth
+    std::vector<TimePoint> totalDepthTime;
+    std::vector<int>       depthCount;
+
     engine.search_clear();  // search_clear may take a while
 
     for (const auto& cmd : setup.commands)
@@ -668,6 +780,9 @@ void UCIEngine::benchmark(std::istream& args) {
 
             Search::LimitsType limits = parse_limits(is);
 
+            depthTime.clear();
+            lastLine = 0;
+
             TimePoint elapsed = now();
 
             // Run with silenced network verification
@@ -678,6 +793,18 @@ void UCIEngine::benchmark(std::istream& args) {
 
             updateHashfullReadings();
 
+            if (depthTime.size() > totalDepthTime.size())
+            {
+                totalDepthTime.resize(depthTime.size());
+                depthCount.resize(depthTime.size());
+            }
+
+            for (size_t d = 1; d < depthTime.size(); ++d)
+            {
+                totalDepthTime[d] += depthTime[d];
+                depthCount[d]++;
+            }
+
             nodes += nodesSearched;
             nodesSearched = 0;
         }
@@ -703,6 +830,18 @@ void UCIEngine::benchmark(std::istream& args) {
     if (threadBinding.empty())
         threadBinding = "none";
 
+    // Report the time to the deepest depth that was completed in every position,
+    // and the depth completed on average
+    int commonDepth = 0, depthSum = 0;
+    while (commonDepth + 1 < int(depthCount.size()) && depthCount[commonDepth + 1] == numGoCommands)
+        ++commonDepth;
+
+    for (int count : depthCount)
+        depthSum += count;
+
+    const TimePoint timeToDepth =
+      commonDepth ? totalDepthTime[commonDepth] / numGoCommands : TimePoint(0);
+
     // clang-format off
 
     std::cerr << "==========================="
@@ -718,6 +857,7 @@ void UCIEngine::benchmark(std::istream& args) {
               << "\nThread count               : " << setup.threads
               << "\nThread binding             : " << threadBinding
               << "\nTT size [MiB]              : " << setup.ttSize
+              << "\nMultiPV                    : " << setup.multiPV
               << "\nHash max, avg [per mille]  : "
               << "\n    single search          : " << maxHashfull[0] << ", "
               << totalHashfull[0] / numHashfullReadings
@@ -725,7 +865,10 @@ void UCIEngine::benchmark(std::istream& args) {
               << totalHashfull[1] / numHashfullReadings
               << "\nTotal nodes searched       : " << nodes
               << "\nTotal search time [s]      : " << totalTime / 1000.0
-              << "\nNodes/second               : " << 1000 * nodes / totalTime << std::endl;
+              << "\nNodes/second               : " << 1000 * nodes / totalTime
+              << "\nAvg time to depth [ms]     : " << timeToDepth << " (depth " << commonDepth
+              << ")"
+              << "\nAvg depth                  : " << double(depthSum) / numGoCommands << std::endl;
 
     // clang-format on
 
@@ -743,6 +886,390 @@ void UCIEngine::benchmark(std::istream& args) {
 #endif
 }
 
+void UCIEngine::movegen_bench(std::istream& args) {
+    int         iterations = 20000;
+    std::string fenFile    = "default";
+
+    if (!(args >> iterations) || iterations <= 0)
+        iterations = 20000;
+    args >> fenFile;
+
+    // Reuse the bench position list, only the "position" and "setoption" entries matter
+    std::istringstream benchArgs("16 1 1 " + fenFile + " depth");
+    std::vector<std::string> list = Benchmark::setup_bench(engine.fen(), benchArgs);
+
+    std::deque<StateInfo>                  states;
+    std::vector<std::unique_ptr<Position>> positions;
+    std::string                            token;
+    const bool                             chess960 = engine.get_options()["UCI_Chess960"];
+
+    for (const auto& cmd : list)
+    {
+        std::istringstream is(cmd);
+        is >> std::skipws >> token;
+
+        // Leave Hash and Threads untouched, this benchmark does not search
+        if (token == "setoption" && cmd.find("UCI_Chess960") != std::string::npos)
+            setoption(is);
+        else if (token == "position")
+        {
+            position(is);
+            positions.push_back(std::make_unique<Position>());
+            positions.back()->set(engine.fen(), engine.get_options()["UCI_Chess960"],
+                                  &states.emplace_back());
+        }
+    }
+
+    uint64_t checksum = 0;
+
+    auto run = [&](const char* name, auto generateCount) {
+        TimePoint elapsed = now();
+        uint64_t  moves   = generateCount();
+        elapsed           = std::max<TimePoint>(now() - elapsed, 1);
+
+        std::cerr << "\n" << name << std::string(14 - std::strlen(name), ' ') << ": " << moves
+                  << " moves in " << elapsed << " ms, " << 1000 * moves / elapsed
+                  << " moves/second";
+    };
+
+    std::cerr << "\n===========================" << "\nPositions     : " << positions.size()
+              << "\nIterations    : " << iterations;
+
+    run("CAPTURES",
+        [&] { return Benchmark::movegen_count<CAPTURES>(positions, iterations, checksum); });
+    run("QUIETS",
+        [&] { return Benchmark::movegen_count<QUIETS>(positions, iterations, checksum); });
+    run("EVASIONS",
+        [&] { return Benchmark::movegen_count<EVASIONS>(positions, iterations, checksum); });
+    run("NON_EVASIONS",
+        [&] { return Benchmark::movegen_count<NON_EVASIONS>(positions, iterations, checksum); });
+    run("LEGAL", [&] { return Benchmark::movegen_count<LEGAL>(positions, iterations, checksum); });
+
+    std::cerr << "\nChecksum      : " << checksum << std::endl;
+
+    auto ss = std::istringstream(std::string("name UCI_Chess960 value ")
+                                 + (chess960 ? "true" : "false"));
+    setoption(ss);
+}
+
+// Evaluates the children of the bench positions, with and without prefetching
+// the NNUE weights when making the moves. The caches are flushed before each
+// position by reading a buffer of the given size, which should exceed the
+// last level cache, so that the weights are read from memory.
+void UCIEngine::eval_bench(std::istream& args) {
+    int         iterations = 4;
+    std::string fenFile    = "default";
+    std::size_t evictMB    = 256;
+
+    if (!(args >> iterations) || iterations <= 0)
+        iterations = 4;
+    args >> fenFile;
+    if (!(args >> evictMB))
+        evictMB = 256;
+
+    std::istringstream       benchArgs("16 1 1 " + fenFile + " depth");
+    std::vector<std::string> list = Benchmark::setup_bench(engine.fen(), benchArgs);
+    std::vector<std::string> fens;
+
+    for (const auto& cmd : list)
+        if (cmd.find("position fen ") == 0)
+            fens.push_back(cmd.substr(13));
+
+    engine.verify_networks();
+
+    std::cerr << "\n===========================" << "\nPositions     : " << fens.size()
+              << "\nIterations    : " << iterations << "\nEviction (MB) : " << evictMB;
+
+    uint64_t evictSum = 0;
+
+    for (bool prefetch : {false, true})
+    {
+        const auto stats   = engine.eval_bench(fens, iterations, evictMB, prefetch);
+        const auto elapsed = std::max(stats.elapsedMs, 0.001);
+
+        evictSum += stats.evictSum;
+
+        std::cerr << "\n" << (prefetch ? "Prefetch      : " : "No prefetch   : ") << stats.evals
+                  << " evals in " << uint64_t(elapsed) << " ms, "
+                  << uint64_t(1000 * stats.evals / elapsed) << " evals/second";
+    }
+
+    // The sum is printed so that the eviction reads cannot be optimized away
+    std::cerr << "\nEviction sum  : " << evictSum << std::endl;
+}
+
+// Plays games between two sets of option values and prints the score of the
+// first one, for SPSA tuning without an external match manager:
+//   selfplay [games N] [concurrency N] [openings <epd file>] [nodes N | movetime MS]
+//            [hash MB] [maxplies N] [paramsA name=value,...] [paramsB name=value,...]
+// Spaces in option names are written as underscores, e.g. Experience_Prefill.
+void UCIEngine::selfplay(std::istream& args) {
+    SelfPlay::Config config;
+    SelfPlay::Params params[2];
+    std::string      token, openingsFile;
+
+    config.concurrency = size_t(engine.get_options()["Threads"]);
+
+    while (args >> token)
+        if (token == "games")
+            args >> config.games;
+        else if (token == "concurrency")
+            args >> config.concurrency;
+        else if (token == "openings")
+            args >> openingsFile;
+        else if (token == "nodes")
+            args >> config.limits.nodes;
+        else if (token == "movetime")
+            args >> config.limits.movetime;
+        else if (token == "hash")
+            args >> config.hashMB;
+        else if (token == "maxplies")
+            args >> config.maxPlies;
+        else if (token == "paramsA" || token == "paramsB")
+        {
+            auto&       list = params[token == "paramsB"];
+            std::string pair;
+
+            args >> token;
+            std::istringstream ss(token);
+
+            while (std::getline(ss, pair, ','))
+            {
+                const auto eq   = pair.find('=');
+                auto       name = pair.substr(0, eq);
+
+                if (!engine.get_options().count(name))
+                    std::replace(name.begin(), name.end(), '_', ' ');
+
+                if (eq == std::string::npos || !engine.get_options().count(name))
+                {
+                    sync_cout << "info string selfplay: bad parameter " << pair << sync_endl;
+                    return;
+                }
+                list.emplace_back(name, pair.substr(eq + 1));
+            }
+        }
+
+    if (!config.limits.nodes && !config.limits.movetime)
+        config.limits.nodes = 10000;
+
+    // EPD lines keep their first four fields, the move counters are reset
+    if (!openingsFile.empty())
+    {
+        std::ifstream file(openingsFile);
+        std::string   line;
+
+        if (!file.is_open())
+        {
+            sync_cout << "info string selfplay: unable to open " << openingsFile << sync_endl;
+            return;
+        }
+
+        while (std::getline(file, line))
+        {
+            std::istringstream ss(line);
+            std::string        fen, field;
+
+            for (int i = 0; i < 4 && ss >> field; ++i)
+                fen += (i ? " " : "") + field;
+
+            if (std::count(fen.begin(), fen.end(), ' ') == 3)
+                config.openings.push_back(fen + " 0 1");
+        }
+    }
+
+    const auto result = engine.selfplay(config, params);
+
+    sync_cout << "W " << result.wins << " D " << result.draws << " L " << result.losses
+              << sync_endl;
+}
+
+// Measures the cost of reading the node count of a running search, as done by
+// the main thread for time checks, nodes limits and info lines, for thread
+// counts doubling up to the given one. Both the aggregated counter and a scan
+// of all the threads are timed while the search threads are busy.
+void UCIEngine::nodes_bench(std::istream& args) {
+    size_t maxThreads = size_t(engine.get_options()["Threads"]);
+    int    duration   = 1000;
+
+    if (!(args >> maxThreads) || maxThreads == 0)
+        maxThreads = size_t(engine.get_options()["Threads"]);
+    if (!(args >> duration) || duration <= 0)
+        duration = 1000;
+
+    const std::string origThreads = std::to_string(int(engine.get_options()["Threads"]));
+
+    engine.set_on_iter([](const auto&) {});
+    engine.set_on_update_no_moves([](const auto&) {});
+    engine.set_on_update_full([](const auto&) {});
+    engine.set_on_bestmove([](const auto&, const auto&) {});
+    engine.set_on_verify_networks([](const auto&) {});
+
+    std::cerr << "\n===========================" << "\nThreads  Nodes/second  Aggregated (ns/read)  Scan (ns/read)";
+
+    for (size_t t = 1;; t = std::min(2 * t, maxThreads))
+    {
+        auto ss = std::istringstream("name Threads value " + std::to_string(t));
+        setoption(ss);
+
+        Search::LimitsType limits;
+        limits.startTime = now();
+        limits.infinite  = true;
+        engine.go(limits);
+
+        // Alternate between the two methods so that both see the same load
+        constexpr int Reads = 4096;
+        double        ns[2] = {0, 0};
+        uint64_t      reads = 0;
+        [[maybe_unused]] volatile uint64_t sink;
+        TimePoint     end   = now() + duration;
+
+        while (now() < end)
+        {
+            for (int byScan = 0; byScan < 2; ++byScan)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < Reads; ++i)
+                    sink = engine.nodes_searched(byScan);
+                ns[byScan] += std::chrono::duration<double, std::nano>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+            }
+            reads += Reads;
+        }
+
+        engine.stop();
+        engine.wait_for_search_finished();
+
+        const uint64_t nps = 1000 * engine.nodes_searched(true) / (now() - limits.startTime + 1);
+
+        std::cerr << "\n" << std::setw(7) << t << std::setw(14) << nps << std::setw(22) << std::fixed
+                  << std::setprecision(1) << ns[0] / std::max<uint64_t>(reads, 1) << std::setw(16)
+                  << ns[1] / std::max<uint64_t>(reads, 1);
+
+        if (t == maxThreads)
+            break;
+    }
+
+    std::cerr << std::endl;
+
+    auto ss = std::istringstream("name Threads value " + origThreads);
+    setoption(ss);
+
+    init_search_update_listeners();
+}
+
+// Measures the latency of the thread pool operations run between searches, like
+// on ucinewgame or a Hash change, with the current Threads and Hash values
+void UCIEngine::pool_bench(std::istream& args) {
+    int iterations = 20;
+
+    if (!(args >> iterations) || iterations <= 0)
+        iterations = 20;
+
+    std::cerr << "\n==========================="
+              << "\nThreads " << int(engine.get_options()["Threads"]) << ", Hash "
+              << int(engine.get_options()["Hash"]) << " MB, " << iterations << " iterations"
+              << "\nThe hash and the histories are cleared, as by ucinewgame"
+              << "\nOperation                      Latency (us)";
+
+    for (const auto& [name, us] : engine.pool_latency(iterations))
+        std::cerr << "\n" << std::left << std::setw(31) << name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(12) << us;
+
+    std::cerr << std::endl;
+}
+
+// Measures, for thread counts doubling up to the given one, the time from "go"
+// until every thread has searched a node, and from "stop" until the best move
+// is sent, averaged over the given number of infinite searches
+void UCIEngine::thread_bench(std::istream& args) {
+    size_t maxThreads = size_t(engine.get_options()["Threads"]);
+    int    iterations = 50;
+
+    if (!(args >> maxThreads) || maxThreads == 0)
+        maxThreads = size_t(engine.get_options()["Threads"]);
+    if (!(args >> iterations) || iterations <= 0)
+        iterations = 50;
+
+    const std::string origThreads = std::to_string(int(engine.get_options()["Threads"]));
+
+#if defined(SUG_FIXED_ZOBRIST)
+    // Do not write the results of the searches to the experience file
+    Experience::g_benchMode.store(true, std::memory_order_relaxed);
+#endif
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point bestmoveTime;
+
+    engine.set_on_iter([](const auto&) {});
+    engine.set_on_update_no_moves([](const auto&) {});
+    engine.set_on_update_full([](const auto&) {});
+    engine.set_on_bestmove([&](const auto&, const auto&) { bestmoveTime = Clock::now(); });
+    engine.set_on_verify_networks([](const auto&) {});
+
+    std::cerr << "\n===========================" << "\nThreads  Go to search (us)  Stop to bestmove (us)";
+
+    for (size_t t = 1;; t = std::min(2 * t, maxThreads))
+    {
+        auto ss = std::istringstream("name Threads value " + std::to_string(t));
+        setoption(ss);
+
+        double goUs = 0, stopUs = 0;
+        bool   started = true;
+
+        for (int i = 0; i < iterations; ++i)
+        {
+            Search::LimitsType limits;
+            limits.startTime = now();
+            limits.infinite  = true;
+
+            const auto goTime = Clock::now();
+            engine.go(limits);
+
+            // Without legal moves no thread ever searches a node, give up then
+            while (engine.searching_threads() < t && Clock::now() - goTime < std::chrono::seconds(1))
+                std::this_thread::yield();
+
+            started = engine.searching_threads() >= t;
+
+            goUs += std::chrono::duration<double, std::micro>(Clock::now() - goTime).count();
+
+            const auto stopTime = Clock::now();
+            engine.stop();
+            engine.wait_for_search_finished();
+
+            stopUs += std::chrono::duration<double, std::micro>(bestmoveTime - stopTime).count();
+
+            if (!started)
+                break;
+        }
+
+        if (!started)
+        {
+            std::cerr << "\nThe search threads did not start, the position may have no legal moves";
+            break;
+        }
+
+        std::cerr << "\n" << std::setw(7) << t << std::fixed << std::setprecision(1)
+                  << std::setw(19) << goUs / iterations << std::setw(23) << stopUs / iterations;
+
+        if (t == maxThreads)
+            break;
+    }
+
+    std::cerr << std::endl;
+
+#if defined(SUG_FIXED_ZOBRIST)
+    Experience::g_benchMode.store(false, std::memory_order_relaxed);
+#endif
+
+    auto ss = std::istringstream("name Threads value " + origThreads);
+    setoption(ss);
+
+    init_search_update_listeners();
+}
+
 void UCIEngine::setoption(std::istringstream& is) {
     engine.wait_for_search_finished();
     engine.get_options().setoption(is);
@@ -754,8 +1281,11 @@ std::uint64_t UCIEngine::perft(const Search::LimitsType& limits) {
     return nodes;
 }
 
-void UCIEngine::position(std::istringstream& is) {
-    std::string token, fen;
+namespace {
+
+// Reads the arguments of a position command, returns false if malformed
+bool parse_position(std::istream& is, std::string& fen, std::vector<std::string>& moves) {
+    std::string token;
 
     is >> token;
 
@@ -768,16 +1298,93 @@ void UCIEngine::position(std::istringstream& is) {
         while (is >> token && token != "moves")
             fen += token + " ";
     else
-        return;
-
-    std::vector<std::string> moves;
+        return false;
 
     while (is >> token)
     {
         moves.push_back(token);
     }
 
-    engine.set_position(fen, moves);
+    return true;
+}
+
+}  // namespace
+
+void UCIEngine::position(std::istringstream& is) {
+    std::string              fen;
+    std::vector<std::string> moves;
+
+    if (parse_position(is, fen, moves))
+        engine.set_position(fen, moves);
+}
+
+// Runs a command for one of the games hosted besides the main one, so that a
+// server can play many games with one copy of the networks and Experience:
+//   session <id> position|go|stop|ponderhit|setoption|ucinewgame|isready|close
+// A session is opened by its first command and starts with the current engine
+// options but the default Threads and Hash. The threads of the main search and
+// of all the sessions stay within "Server Threads". Its output lines are prefixed by "session <id>". Without arguments the open
+// sessions are listed.
+void UCIEngine::session(std::istringstream& is) {
+    auto&       sessions = engine.get_sessions();
+    std::string id, token;
+
+    if (!(is >> id))
+    {
+        for (const auto& line : sessions.information())
+            print_info_string(line);
+
+        print_info_string(std::to_string(sessions.size()) + " sessions, "
+                          + std::to_string(sessions.thread_count()) + " of "
+                          + std::to_string(sessions.thread_budget())
+                          + " server threads used with the main search");
+        return;
+    }
+
+    is >> token;
+
+    if (token == "close")
+    {
+        if (!sessions.close(id))
+            print_info_string("no session " + id);
+        return;
+    }
+
+    if (!sessions.open(id))
+        return;
+
+    if (token == "position")
+    {
+        std::string              fen;
+        std::vector<std::string> moves;
+
+        if (parse_position(is, fen, moves))
+            sessions.set_position(id, fen, moves);
+    }
+    else if (token == "go")
+    {
+        Search::LimitsType limits = parse_limits(is);
+
+        if (limits.perft)
+            print_info_string("perft is not supported in sessions");
+        else
+        {
+            engine.verify_networks();
+            sessions.go(id, limits);
+        }
+    }
+    else if (token == "stop")
+        sessions.stop(id);
+    else if (token == "ponderhit")
+        sessions.set_ponderhit(id);
+    else if (token == "setoption")
+        sessions.setoption(id, is);
+    else if (token == "ucinewgame")
+        sessions.search_clear(id);
+    else if (token == "isready")
+        sync_cout << "session " << id << " readyok" << sync_endl;
+    else if (!token.empty())
+        sync_cout << "Unknown session command: '" << token << "'." << sync_endl;
 }
 
 namespace { // anonymous helpers only for win_rate_model
@@ -880,11 +1487,11 @@ Move UCIEngine::to_move(const Position& pos, std::string str) {
     return Move::none();
 }
 
-void UCIEngine::on_update_no_moves(const Engine::InfoShort& info) {
-    sync_cout << "info depth " << info.depth << " score " << format_score(info.score) << sync_endl;
+std::string UCIEngine::format_update_no_moves(const Engine::InfoShort& info) {
+    return "info depth " + std::to_string(info.depth) + " score " + format_score(info.score);
 }
 
-void UCIEngine::on_update_full(const Engine::InfoFull& info) {
+std::string UCIEngine::format_update_full(const Engine::InfoFull& info) {
     std::stringstream ss;
 
     ss << "info";
@@ -903,10 +1510,10 @@ void UCIEngine::on_update_full(const Engine::InfoFull& info) {
        << " time " << info.timeMs        //
        << " pv " << info.pv;             //
 
-    sync_cout << ss.str() << sync_endl;
+    return ss.str();
 }
 
-void UCIEngine::on_iter(const Engine::InfoIter& info) {
+std::string UCIEngine::format_iter(const Engine::InfoIter& info) {
     std::stringstream ss;
 
     ss << "info";
@@ -914,14 +1521,30 @@ void UCIEngine::on_iter(const Engine::InfoIter& info) {
        << " currmove " << info.currmove               //
        << " currmovenumber " << info.currmovenumber;  //
 
-    sync_cout << ss.str() << sync_endl;
+    return ss.str();
 }
 
-void UCIEngine::on_bestmove(std::string_view bestmove, std::string_view ponder) {
-    sync_cout << "bestmove " << bestmove;
+std::string UCIEngine::format_bestmove(std::string_view bestmove, std::string_view ponder) {
+    std::string str = "bestmove " + std::string(bestmove);
     if (!ponder.empty())
-        std::cout << " ponder " << ponder;
-    std::cout << sync_endl;
+        str += " ponder " + std::string(ponder);
+    return str;
+}
+
+void UCIEngine::on_update_no_moves(const Engine::InfoShort& info) {
+    sync_cout << format_update_no_moves(info) << sync_endl;
+}
+
+void UCIEngine::on_update_full(const Engine::InfoFull& info) {
+    sync_cout << format_update_full(info) << sync_endl;
+}
+
+void UCIEngine::on_iter(const Engine::InfoIter& info) {
+    sync_cout << format_iter(info) << sync_endl;
+}
+
+void UCIEngine::on_bestmove(std::string_view bestmove, std::string_view ponder) {
+    sync_cout << format_bestmove(bestmove, ponder) << sync_endl;
 
 #if defined(HYP_FIXED_ZOBRIST)
     Experience::save();
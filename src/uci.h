@@ -26,6 +26,7 @@
 
 #include "engine.h"
 #include "misc.h"
+#include "output.h"
 #include "search.h"
 
 namespace Sugar {
@@ -52,9 +53,15 @@ class UCIEngine {
 
     static Search::LimitsType parse_limits(std::istream& is);
 
+    static std::string format_update_no_moves(const Engine::InfoShort& info);
+    static std::string format_update_full(const Engine::InfoFull& info);
+    static std::string format_iter(const Engine::InfoIter& info);
+    static std::string format_bestmove(std::string_view bestmove, std::string_view ponder);
+
     auto& engine_options() { return engine.get_options(); }
 
    private:
+    AsyncOutput output;  // Declared first so that it outlives the search threads
     Engine      engine;
     CommandLine cli;
 
@@ -63,6 +70,13 @@ class UCIEngine {
     void          go(std::istringstream& is);
     void          bench(std::istream& args);
     void          benchmark(std::istream& args);
+    void          movegen_bench(std::istream& args);
+    void          nodes_bench(std::istream& args);
+    void          pool_bench(std::istream& args);
+    void          thread_bench(std::istream& args);
+    void          eval_bench(std::istream& args);
+    void          selfplay(std::istream& args);
+    void          session(std::istringstream& is);
     void          position(std::istringstream& is);
     void          setoption(std::istringstream& is);
     std::uint64_t perft(const Search::LimitsType&);
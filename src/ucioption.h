@@ -59,6 +59,7 @@ class Option {
    private:
     friend class OptionsMap;
     friend class Engine;
+    friend class SessionServer;
     friend class Tune;
 
 
@@ -91,6 +92,7 @@ class OptionsMap {
 
    private:
     friend class Engine;
+    friend class SessionServer;
     friend class Option;
 
     friend std::ostream& operator<<(std::ostream&, const OptionsMap&);